@@ -13,6 +13,7 @@ private:
     static void init_king_table();
     static void init_rook_table();
     static void init_bishop_table();
+    static void init_line_tables();
 
     // non-sliding
     static u64 pawn_attack_table[2][64];
@@ -21,6 +22,9 @@ private:
     // sliding (no need for queen attacks)
     static u64 rook_attack_table[64][4096];
     static u64 bishop_attack_table[64][512];
+    // squares strictly between / the whole line through two aligned squares, 0 if not aligned
+    static u64 between_table[64][64];
+    static u64 line_table[64][64];
 
     static u64 rook_magics[64];
     static u64 bishop_magics[64];
@@ -69,4 +73,6 @@ public:
     static u64 rook_attacks(Square square, u64 blockers);
     static u64 bishop_attacks(Square square, u64 blockers);
     static u64 queen_attacks(Square square, u64 blockers);
+    static u64 between(Square a, Square b);
+    static u64 line(Square a, Square b);
 };
\ No newline at end of file
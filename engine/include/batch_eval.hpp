@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "board.hpp"
+
+/*
+ * A position in 32 bytes, the record format of binary position files:
+ * the occupied squares, then one nibble per occupied square in square order
+ * (color * 8 + piece type), then side to move, castling rights and the en
+ * passant square (64 for none). Move counters are not kept.
+ */
+struct PackedPosition
+{
+    u64 occupancy;
+    uint8_t pieces[16];
+    uint8_t side;
+    uint8_t castling;
+    uint8_t enpassant;
+    uint8_t padding[5];
+
+    static bool from_fen(const std::string &fen, PackedPosition &packed);
+    bool valid() const;
+    void unpack(Board &board) const; // the record has to be valid()
+};
+
+static_assert(sizeof(PackedPosition) == 32, "binary position files depend on the record size");
+
+/*
+ * Static evaluation of many positions at once, split into contiguous chunks
+ * over worker threads. Each worker unpacks straight into its own Board and
+ * Evaluator, so there is no FEN parsing and no sharing between threads.
+ */
+class BatchEvaluator
+{
+private:
+    int thread_count;
+
+public:
+    BatchEvaluator(int threads = 0); // 0: one per hardware thread
+
+    // scores[i] is the evaluation of positions[i], side to move's point of view
+    void evaluate(const PackedPosition *positions, size_t count, int *scores);
+};
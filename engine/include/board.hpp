@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -6,11 +8,37 @@
 #include <cstdint> // for uint64_t
 #include "common/types.hpp"
 #include "attack_tables.hpp"
+#include "zobrist.hpp"
+#include "psqt.hpp"
+#include "nnue.hpp"
 
 using namespace std;
 
 using u64 = unsigned long long;
 
+enum GenType
+{
+    GEN_ALL,
+    GEN_CAPTURES,
+    GEN_QUIETS,
+    GEN_QUIET_CHECKS // quiet moves giving direct or discovered check, no promotions (side to move only)
+};
+
+/*
+ * Everything make_move overwrites that can't be recovered from the move encoding.
+ * One entry is pushed per move and popped again by unmake_move.
+ */
+struct BoardState
+{
+    int move;
+    u64 hash;
+    u64 enpassant_square;
+    int castling_rights;
+    u64 checkers;
+    u64 king_blockers[2];
+    u64 check_squares[7];
+};
+
 class Board
 {
 private:
@@ -19,31 +47,96 @@ private:
     u64 blockers[2] = {};
     u64 one_bit = 1;
     Color side_to_move = WHITE;
-    std::stack<int> move_stack;
+    std::stack<BoardState> state_stack;
     char piece_types[2][7] = {{' ', 'P', 'N', 'B', 'R', 'Q', 'K'},
                               {' ', 'p', 'n', 'b', 'r', 'q', 'k'}};
-    u64 enpassant_square;
+    u64 enpassant_square = 0;
+    int castling_rights = 0;
+    u64 hash = 0;
+    u64 pawn_key = 0; // zobrist hash of the pawns alone, for the pawn structure cache
+    Score psq = 0; // material + piece-square sum, white's point of view, kept up to date by put_piece/remove_piece
+    int phase = 0; // non-pawn material in PSQT::PHASE_WEIGHTS units, 24 at the start (can exceed it after promotions)
+    u64 material_signature = 0; // piece counts, 4 bits per [color][type]
+    u64 checkers = 0;            // enemy pieces giving check to the side to move
+    u64 king_blockers[2] = {};   // pieces of either color that are the only thing between a king and an enemy slider
+    u64 check_squares[7] = {};   // squares from which a piece of each type of the side to move would attack the enemy king
+    bool use_nnue = false;       // a network is loaded, accumulators are kept up to date
+    vector<Accumulator> accumulators; // one per entry of state_stack, [0] for the loaded position
+    AccumulatorDelta delta;      // pieces changed by the move being made
     u64 castle_masks[2][2] = {{0b11ULL << 61, 0b111ULL << 57}, {0b11ULL << 5, 0b111ULL << 1}};
+    u64 castle_safe_masks[2][2] = {{0b11ULL << 61, 0b11ULL << 58}, {0b11ULL << 5, 0b11ULL << 2}};
     u64 castle_square[2][2] = {{1ULL << 62, 1ULL << 58}, {1ULL << 6, 1ULL << 2}};
+    int castle_rights_for[2][2] = {{WHITE_KINGSIDE, WHITE_QUEENSIDE}, {BLACK_KINGSIDE, BLACK_QUEENSIDE}};
+
+    void put_piece(Color color, PieceType type, Square square);
+    void remove_piece(Color color, PieceType type, Square square);
+    void generate_check_and_pin_masks(Color color, u64 &checkmask, bool &double_check, u64 pin_masks[64]);
+    void update_check_info();
+    void push_state(int move);
+    void init_derived_state();
+    void record_delta(int sign, Color color, PieceType type, Square square);
+    void push_accumulator();
+    u64 slider_blockers(Color color);
+    u64 quiet_check_targets(Color color, PieceType type, Square start);
+    void add_pawn_moves(vector<int> &moves, int move, GenType type);
 
 public:
+    Board();
     void set_square(int i, int value);
     void load_fen(string fen);
+    void set_position(const u64 piece_bitboards[2][7], Color side, int castling, u64 enpassant);
     int type_of(char p);
     void print();
     bool make_move(Square start, Square target, Color turn, vector<int> legal_moves);
+    bool make_move(int move);
     bool unmake_move();
+    void make_null_move();
+    void unmake_null_move();
     vector<int> generate_legal_moves(Color color);
+    vector<int> generate_moves(Color color, GenType type, bool use_evasions = true);
+    vector<int> generate_evasions(Color color, GenType type);
     bool is_legal_move(Square start, Square target, Color turn);
+    bool is_pseudo_legal(int move);
+    bool is_legal(int move);
+    int build_move(Square start, Square target, PieceType promotion = QUEEN);
+    u64 get_checkers();
+    u64 get_king_blockers(Color color);
+    bool gives_check(int move);
     u64 get_attacks(Color color);
     void print_bitboard(string label, u64 bitboard);
     void print_move_encoding(string label, int number);
     Color get_side();
+    u64 get_hash();
+    int last_move();
+    u64 compute_hash();
+    u64 get_pawn_key();
+    u64 compute_pawn_key();
+    Score get_psq();
+    Score compute_psq();
+    int get_phase();
+    int compute_phase();
+    u64 get_material_signature();
+    u64 compute_material_signature();
+    int material_count(Color color, PieceType type);
+    bool nnue_enabled();
+    void sync_network();
+    const Accumulator &get_accumulator();
+    void refresh_accumulator();
+    u64 get_pieces(Color color, PieceType type);
+    u64 get_occupancy(Color color);
+    int non_pawn_material(Color color);
+    bool in_check();
+    u64 attackers_to(Square square, u64 occupancy);
+    bool squares_attacked(u64 squares_bb, Color color);
+    int see(int move);
+    bool see_ge(int move, int threshold);
     bool is_checkmate(Color turn);
     bool is_stalemate(Color turn);
     u64 generate_checkmask(Color turn);
     int get_piece_at_square(Square sq);
     long perft(int depth, int max_depth);
     string coordinates(int square);
+    string move_to_string(int move);
+    int parse_move(string text);
     void print_profiling();
-};
\ No newline at end of file
+};
@@ -4,6 +4,10 @@ using u64 = unsigned long long;
 
 constexpr int BOARD_SIZE = 64;
 constexpr int NUM_PIECES = 6;
+constexpr int MAX_PLY = 128;
+
+// centipawn values indexed by PieceType, the king only matters to exchange evaluation
+constexpr int PIECE_VALUES[7] = {0, 100, 320, 330, 500, 900, 20000};
 
 enum Color
 {
@@ -28,6 +32,14 @@ enum CastleSide
     QUEENSIDE
 };
 
+enum CastlingRights
+{
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8
+};
+
 enum Square
 {
     a8,
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "board.hpp"
+
+// scores from known winning endgames sit above any normal evaluation but well below mate scores
+constexpr int KNOWN_WIN = 10000;
+
+// exact evaluation of a known endgame, from the strong side's point of view
+using EndgameEvaluation = int (*)(Board &board, Color strong);
+// factor out of 64 applied to the endgame part of the normal evaluation
+using EndgameScaling = int (*)(Board &board);
+
+/*
+ * Specialised evaluation for endgames the general terms get wrong. The
+ * material table picks one of these from the piece counts alone.
+ */
+class Endgames
+{
+public:
+    static int draw(Board &board, Color strong);
+    static int kxk(Board &board, Color strong); // lone king against a rook or queen (KRK, KQK, ...)
+    static int kbnk(Board &board, Color strong);
+    static int kpk(Board &board, Color strong);
+    static int kqkr(Board &board, Color strong);
+
+    static int opposite_bishops(Board &board); // a bishop each plus pawns, drawish when the bishops run on different colors
+};
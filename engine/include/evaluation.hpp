@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "board.hpp"
+#include "material.hpp"
+#include "pawns.hpp"
+#include "psqt.hpp"
+
+/*
+ * Attack maps built once per evaluation and shared by every term that needs
+ * them: mobility, king safety and threats all read from here instead of
+ * querying AttackTables again.
+ */
+struct AttackInfo
+{
+    u64 by_type[2][7];        // squares attacked by the pieces of each type
+    u64 all[2];               // squares attacked by anything
+    u64 king_zone[2];         // king square and its neighbours
+    int king_attackers[2];    // enemy pieces hitting the zone
+    int king_attack_weight[2]; // weighted zone hits by those pieces
+    int mobility[2][7];       // safe destination squares minus MOBILITY_BASE, summed per piece type
+    u64 threatened[2];        // enemy pieces attacked by a cheaper piece of this color
+    u64 hanging[2];           // enemy pieces attacked by this color and not defended
+};
+
+/*
+ * Static evaluation. One Evaluator per search thread, so per-thread caches
+ * can live here without locking.
+ */
+class Evaluator
+{
+private:
+    static constexpr size_t CACHE_SIZE = 1 << 16; // entries, a power of two
+
+    // full position hash in the upper 48 bits, score in the lower 16 (the index covers the rest of the key)
+    std::vector<u64> cache;
+
+    int compute(Board &board, int alpha, int beta, bool &lazy);
+    Score evaluate_pieces(Board &board, PawnEntry *pawns);
+    Score evaluate_king_safety(Color color);
+    Score evaluate_threats(Board &board);
+
+public:
+    static constexpr int NO_BOUND = 1 << 20; // a window that never lets the evaluation stop early
+    static constexpr int LAZY_MARGIN = 400;  // what the terms past material and piece-square tables can plausibly add up to
+
+    // per safe destination square, relative to a typical count so an average piece scores about zero
+    static constexpr Score MOBILITY[7] = {0, 0, make_score(4, 4), make_score(5, 5), make_score(2, 4), make_score(1, 2), 0};
+    static constexpr int MOBILITY_BASE[7] = {0, 0, 4, 7, 7, 14, 0};
+    // how much a piece hitting the enemy king zone counts towards the attack
+    static constexpr int KING_ATTACK_WEIGHTS[7] = {0, 0, 2, 2, 3, 5, 0};
+    static constexpr Score THREAT_BY_LESSER = make_score(40, 25); // piece attacked by a cheaper one
+    static constexpr Score HANGING = make_score(20, 15);          // piece attacked and not defended at all
+
+    PawnTable pawn_table;
+    MaterialTable material_table;
+    long cache_probes = 0;
+    long cache_hits = 0;
+    long lazy_exits = 0; // evaluations cut short by the window
+
+    // benchmarks only: on a lazy exit compute the full score anyway and record how far off the lazy one was
+    bool verify_lazy = false;
+    long lazy_wrong_side = 0; // full score on the other side of the bound the lazy score was outside of
+    long lazy_error = 0;      // summed absolute difference
+    AttackInfo attacks; // from the last full evaluation
+
+    Evaluator();
+
+    // centipawns from the side to move's point of view; outside (alpha, beta) the result may be a cheap estimate
+    int evaluate(Board &board, int alpha = -NO_BOUND, int beta = NO_BOUND);
+    void clear_cache();
+    void reset_stats();
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/types.hpp"
+
+/*
+ * Exact win/draw result for every king and pawn versus king position, built
+ * once by retrograde analysis. Positions are stored with the pawn side as
+ * white and the pawn on files a-d; probe() normalises anything else.
+ */
+class KPKBitbase
+{
+private:
+    static constexpr int SIZE = 2 * 64 * 64 * 24; // side to move x black king x white king x pawn square
+
+    static u64 bits[SIZE / 64];
+
+    static int index(Color side, int white_king, int black_king, int pawn);
+    static void build();
+
+public:
+    static void init();
+    // true if the side with the pawn wins
+    static bool probe(Color strong, Square strong_king, Square pawn, Square weak_king, Color side_to_move);
+};
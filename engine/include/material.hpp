@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "board.hpp"
+#include "endgames.hpp"
+#include "psqt.hpp"
+
+/*
+ * Everything the evaluation derives from the piece counts alone.
+ */
+struct MaterialEntry
+{
+    u64 key = ~0ULL;                        // material signature, never all ones
+    Score imbalance = 0;                    // bishop pair and piece/pawn count adjustments, white's point of view
+    int phase = 0;                          // scaled_phase() of the material
+    EndgameEvaluation evaluation = nullptr; // replaces the general evaluation when set
+    EndgameScaling scaling = nullptr;       // scales its endgame part when set
+    Color strong = WHITE;                   // side the evaluation function is written for
+};
+
+/*
+ * Material cache keyed by the board's material signature. The signature
+ * packs the piece counts exactly, so it is its own key and is only hashed to
+ * pick a slot. Owned by one thread, no locking.
+ */
+class MaterialTable
+{
+private:
+    static constexpr int SIZE_BITS = 12;
+
+    std::vector<MaterialEntry> entries;
+
+    static void analyse(u64 signature, MaterialEntry &entry);
+
+public:
+    static constexpr Score BISHOP_PAIR = make_score(25, 45);
+    // per piece, for every own pawn above five: knights gain with more pawns, rooks lose
+    static constexpr Score KNIGHT_PAWN = make_score(4, 4);
+    static constexpr Score ROOK_PAWN = make_score(-8, -8);
+
+    MaterialTable();
+
+    MaterialEntry *probe(Board &board);
+    void clear();
+};
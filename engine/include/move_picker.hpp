@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "board.hpp"
+
+/*
+ * Per-thread move ordering statistics. The butterfly table is int16 so the
+ * whole structure stays around 20KB and fits in L1/L2 next to the board.
+ */
+struct MoveHistory
+{
+    static constexpr int MAX_HISTORY = 8192;
+
+    int16_t butterfly[2][64][64]; // [color][start][target]
+    int killers[MAX_PLY][2];
+    int countermoves[7][64]; // [piece of the previous move][its target square]
+
+    void clear();
+    void update_quiet(Color color, int move, int bonus);
+    void update_killer(int ply, int move);
+};
+
+enum PickerStage
+{
+    TT_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    QS_GENERATE_CAPTURES,
+    QS_CAPTURES,
+    QS_GENERATE_QUIET_CHECKS,
+    QS_QUIET_CHECKS,
+    DONE
+};
+
+/*
+ * Staged move generator. Moves are only generated when the stage that needs
+ * them is reached, so a node that cuts off on the hash move never generates
+ * anything and one that cuts off on a capture never generates quiets:
+ *
+ *  1. hash move, after checking it is legal here
+ *  2. captures and queen promotions that pass see_ge(0), by MVV-LVA
+ *  3. the two killers and the countermove to the previous move
+ *  4. quiets by butterfly history
+ *  5. losing captures
+ *
+ * Within a stage the best remaining move is selected on demand (selection
+ * sort) rather than sorting the whole list up front.
+ *
+ * The quiescence constructor only runs the captures stage, followed by the
+ * quiet checks on the first quiescence ply.
+ */
+class MovePicker
+{
+private:
+    static constexpr int GOOD_CAPTURE_SCORE = 1 << 28;
+    static constexpr int BAD_CAPTURE_SCORE = -(1 << 28);
+
+    Board &board;
+    MoveHistory &history;
+    PickerStage stage;
+    int tt_move;
+    int ply;
+    int rotation;
+    int refutations[3]; // killers and countermove
+    int refutation_index = 0;
+    bool quiet_checks = false;
+
+    std::vector<int> moves;
+    std::vector<int> scores;
+    std::vector<int> bad_captures;
+    size_t current = 0;
+
+    bool is_tactical(int move);
+    void score_captures();
+    void score_quiets();
+    int select_best();
+
+public:
+    MovePicker(Board &board, MoveHistory &history, int tt_move, int ply, int rotation = 0);
+    MovePicker(Board &board, MoveHistory &history, bool quiet_checks = false);
+
+    int next_move(); // 0 once every move has been returned
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "common/types.hpp"
+
+/*
+ * First layer output for both perspectives, [WHITE] seen from the white king
+ * and [BLACK] from the black king (board mirrored vertically).
+ */
+struct alignas(64) Accumulator
+{
+    int16_t values[2][256];
+};
+
+/*
+ * Pieces added and removed by one move, filled in by put_piece/remove_piece
+ * while make_move runs. Castling is the most a move changes: 4 entries.
+ */
+struct AccumulatorDelta
+{
+    int count = 0;
+    int sign[4];
+    Color color[4];
+    PieceType type[4];
+    Square square[4];
+};
+
+/*
+ * HalfKP network: 2 x (64 king squares x 10 non-king pieces x 64 squares)
+ * inputs -> 2 x 256 -> 32 -> 32 -> 1. The first layer is a sum of weight
+ * rows of the pieces on the board, so a move only adds and subtracts a few
+ * rows from the previous ply's accumulator. Hidden layers are int8 weights on
+ * clipped [0, 127] uint8 activations.
+ *
+ * Network file layout (little endian, every section starts on a 64 byte
+ * boundary so the mapped weights are used in place by aligned SIMD loads):
+ *  header    "NNUE", version (uint32), padded to 64 bytes
+ *  int16     feature biases [256], feature weights [40960][256]
+ *  int32     hidden1 biases [32],  int8 hidden1 weights [32][512]
+ *  int32     hidden2 biases [32],  int8 hidden2 weights [32][32]
+ *  int32     output bias (padded), int8 output weights [32]
+ */
+class NNUE
+{
+public:
+    static constexpr int KING_SQUARES = 64;
+    static constexpr int PIECE_FEATURES = 10 * 64;
+    static constexpr int INPUTS = KING_SQUARES * PIECE_FEATURES;
+    static constexpr int HALF = 256;
+    static constexpr int HIDDEN1 = 32;
+    static constexpr int HIDDEN2 = 32;
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t FILE_SIZE =
+        64 + 2 * HALF + 2 * (size_t)INPUTS * HALF + 4 * HIDDEN1 + HIDDEN1 * 2 * HALF + 4 * HIDDEN2 + HIDDEN2 * HIDDEN1 + 64 + HIDDEN2;
+
+private:
+    static void *mapping;
+    static const int16_t *feature_biases;
+    static const int16_t *feature_weights;
+    static const int32_t *hidden1_biases;
+    static const int8_t *hidden1_weights;
+    static const int32_t *hidden2_biases;
+    static const int8_t *hidden2_weights;
+    static const int32_t *output_bias;
+    static const int8_t *output_weights;
+
+    static int feature(Color perspective, Square king, Color color, PieceType type, Square square);
+
+public:
+    static bool load(const std::string &path);
+    static void unload();
+    static bool loaded();
+
+    // full recompute of one perspective from the pieces on the board
+    static void refresh(Accumulator &accumulator, Color perspective, const u64 pieces[2][7]);
+    // previous ply's accumulator plus the move's delta; a perspective whose king moved is refreshed instead
+    static void update(const Accumulator &previous, Accumulator &next, const AccumulatorDelta &delta, const u64 pieces[2][7]);
+    // centipawns from the side to move's point of view
+    static int evaluate(const Accumulator &accumulator, Color side);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include "board.hpp"
+#include "psqt.hpp"
+
+/*
+ * Everything the pawn structure evaluation derives from the two pawn
+ * bitboards alone. Other evaluation terms can reuse the bitboards without
+ * recomputing them.
+ */
+struct PawnEntry
+{
+    u64 key = 0;
+    Score score = 0;      // doubled, isolated, backward and passed pawn terms, white's point of view
+    u64 passed[2] = {};   // passed pawns per color
+    u64 attacks[2] = {};  // squares attacked by the pawns of each color right now
+    u64 attack_span[2] = {}; // squares the pawns of each color attack now or could attack after advancing
+};
+
+// the pawns each structure term applies to, per color
+struct PawnTerms
+{
+    u64 doubled[2];
+    u64 isolated[2];
+    u64 backward[2];
+    u64 passed[2];
+};
+
+/*
+ * Pawn structure cache, indexed by the board's pawn-only zobrist key. Pawns
+ * move or get captured in only a small fraction of the moves made during a
+ * search, so nearly every lookup is a hit. Owned by one thread, no locking.
+ */
+class PawnTable
+{
+private:
+    static constexpr size_t SIZE = 1 << 14; // entries, a power of two
+
+    std::vector<PawnEntry> entries;
+
+    static void evaluate(u64 white_pawns, u64 black_pawns, PawnEntry &entry);
+
+public:
+    static constexpr Score DOUBLED = make_score(-10, -25);
+    static constexpr Score ISOLATED = make_score(-5, -15);
+    static constexpr Score BACKWARD = make_score(-9, -22);
+    // indexed by rank counted from the pawn's own side, 0 = first rank
+    static constexpr Score PASSED[8] = {0, make_score(5, 10), make_score(10, 17), make_score(15, 25),
+                                        make_score(30, 45), make_score(55, 85), make_score(90, 130), 0};
+
+    long probes = 0;
+    long hits = 0;
+
+    PawnTable();
+
+    static PawnTerms classify(u64 white_pawns, u64 black_pawns);
+
+    PawnEntry *probe(Board &board);
+    void clear();
+    void reset_stats();
+    double hit_rate();
+};
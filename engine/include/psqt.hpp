@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include "common/types.hpp"
+
+/*
+ * A middlegame and an endgame value packed into one int: eg in the upper 16
+ * bits, mg in the lower 16. Two pairs add and subtract with one instruction,
+ * which is what keeps the incremental update in make_move cheap.
+ */
+using Score = int32_t;
+
+constexpr Score make_score(int mg, int eg)
+{
+    return (Score)((uint32_t)eg << 16) + mg;
+}
+
+// the lower half is signed, so the upper half is rounded to undo the borrow it may have taken
+constexpr int mg_value(Score score)
+{
+    return (int16_t)(uint16_t)(uint32_t)score;
+}
+
+constexpr int eg_value(Score score)
+{
+    return (int16_t)(uint16_t)((uint32_t)(score + 0x8000) >> 16);
+}
+
+/*
+ * Material plus piece-square values (PeSTO tables), one Score per
+ * [color][piece type][square], from white's point of view: black entries are
+ * negated and mirrored, so a position's score is the plain sum over its pieces.
+ */
+class PSQT
+{
+private:
+    static void build();
+
+public:
+    static constexpr int MG_VALUES[7] = {0, 82, 337, 365, 477, 1025, 0};
+    static constexpr int EG_VALUES[7] = {0, 94, 281, 297, 512, 936, 0};
+
+    // game phase: how much non-pawn material a piece contributes, 24 for the full starting set
+    static constexpr int PHASE_WEIGHTS[7] = {0, 0, 1, 1, 2, 4, 0};
+    static constexpr int MAX_PHASE = 24;
+
+    // material signature: a 4 bit count per [color][piece type] (kings left out), see Board::material_count
+    static constexpr u64 signature_unit(int color, int type)
+    {
+        return type == KING ? 0 : 1ULL << (4 * (color * 5 + type - 1));
+    }
+
+    static constexpr int signature_count(u64 signature, int color, int type)
+    {
+        return type == KING ? 1 : (signature >> (4 * (color * 5 + type - 1))) & 0xf;
+    }
+
+    static Score table[2][7][64];
+
+    static void init();
+};
+
+// phase 0..MAX_PHASE rescaled to 0..256 (683/64 ~ 256/24), so tapering needs a shift instead of a divide
+constexpr int scaled_phase(int phase)
+{
+    return ((phase < PSQT::MAX_PHASE ? phase : PSQT::MAX_PHASE) * 683) >> 6;
+}
+
+// blend a score pair: 256 is pure middlegame, 0 pure endgame
+constexpr int taper(Score score, int scaled)
+{
+    return eg_value(score) + (((mg_value(score) - eg_value(score)) * scaled) >> 8);
+}
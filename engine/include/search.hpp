@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "board.hpp"
+#include "evaluation.hpp"
+#include "move_picker.hpp"
+#include "time_manager.hpp"
+#include "transposition_table.hpp"
+
+constexpr int INFINITE_SCORE = 32000;
+constexpr int MATE_SCORE = 31000;
+constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY; // scores beyond this are mates
+
+/*
+ * What a "go" asks for. Times are in ms, indexed by color; zero means not given.
+ * With no time, node or depth limit the search runs until stop is called.
+ */
+struct SearchLimits
+{
+    int depth = MAX_PLY - 1;
+    long nodes = 0; // counted on the main thread
+    int64_t movetime = 0;
+    int64_t time[2] = {0, 0};
+    int64_t increment[2] = {0, 0};
+    int movestogo = 0;
+    bool infinite = false;
+    bool ponder = false; // searching the opponent's expected move: the clock runs from go, but the search can't stop before ponderhit
+};
+
+/*
+ * Selective search switches, all on by default. They can be flipped between
+ * searches to measure what each one does to time-to-depth and node counts.
+ */
+struct SearchOptions
+{
+    bool null_move = true;
+    bool late_move_reductions = true;
+    bool reverse_futility = true;
+    bool futility = true;
+    bool late_move_pruning = true;
+    bool razoring = true;
+    bool lazy_eval = true; // quiescence stand pat only
+};
+
+struct SearchResult
+{
+    int best_move = 0;
+    int ponder_move = 0; // second move of the pv, 0 when there is none
+    int score = 0;
+    int depth = 0;
+    long nodes = 0;  // every node, quiescence included
+    long qnodes = 0; // quiescence nodes only
+
+    // move ordering quality: how often a beta cutoff came from the first move searched
+    long beta_cutoffs = 0;
+    long first_move_cutoffs = 0;
+    long null_cutoffs = 0;
+
+    // window tuning: zero-window searches that had to be repeated with the full window,
+    // and root searches repeated after failing outside the aspiration window
+    long pvs_researches = 0;
+    long aspiration_researches = 0;
+
+    // pawn structure cache lookups made by the evaluation, and how many found their entry
+    long pawn_probes = 0;
+    long pawn_hits = 0;
+    // the same for the evaluation cache
+    long eval_probes = 0;
+    long eval_hits = 0;
+    long lazy_evals = 0; // evaluations cut short by lazy evaluation
+};
+
+// progress report sent after every iteration the main thread completes
+struct SearchInfo
+{
+    int depth = 0;
+    int score = 0;
+    long nodes = 0; // all threads
+    int64_t time = 0; // ms
+    int hashfull = 0; // permille
+    std::vector<int> pv;
+};
+
+/*
+ * Per-thread search state. Each thread owns a copy of the root position so
+ * make_move/unmake_move never touch another thread's board.
+ */
+struct alignas(64) SearchThread
+{
+    int id = 0;
+    Board board;
+    std::atomic<long> nodes{0};
+    std::atomic<long> qnodes{0};
+
+    // result of the last iteration this thread completed
+    int completed_depth = 0;
+    int best_move = 0;
+    int ponder_move = 0; // the reply the pv expects, 0 if it stops at the best move
+    int best_score = -INFINITE_SCORE;
+
+    MoveHistory history;
+    Evaluator evaluator;
+    long beta_cutoffs = 0;
+    long first_move_cutoffs = 0;
+    long null_cutoffs = 0;
+    long pvs_researches = 0;
+    long aspiration_researches = 0;
+
+    int pv[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY];
+};
+
+/*
+ * Lazy SMP search. Every thread runs its own iterative deepening on the same
+ * root and the threads only cooperate through the shared transposition table.
+ * Helper threads are desynchronised from the main thread by searching odd
+ * threads one ply deeper and by rotating their root move order, so they fill
+ * the table with entries the main thread hasn't reached yet.
+ */
+class Search
+{
+private:
+    TranspositionTable &tt;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    // written by the UCI reader thread and polled at every node, so each gets a cache line of its own
+    alignas(64) std::atomic<bool> stop{false};
+    alignas(64) std::atomic<bool> pondering{false};
+    TimeManager time_manager;
+    long node_limit = 0;
+    SearchLimits search_limits;
+
+    // late move reductions by [depth][move number], filled in once at startup
+    static int reductions[64][64];
+    static void init_reductions();
+
+    void iterative_deepening(SearchThread &thread, SearchLimits limits);
+    int negamax(SearchThread &thread, int alpha, int beta, int depth, int ply);
+    int quiescence(SearchThread &thread, int alpha, int beta, int ply, int depth);
+    void update_quiet_stats(SearchThread &thread, int move, int depth, int ply, int *quiets_tried, int quiet_count);
+    int evaluate(SearchThread &thread);
+    int evaluate(SearchThread &thread, int alpha, int beta);
+    void poll_limits(SearchThread &thread);
+    SearchThread &pick_best_thread();
+
+public:
+    Search(TranspositionTable &tt, int thread_count = 1);
+
+    void set_threads(int count);
+    int get_threads();
+    void clear_eval_caches();
+    SearchOptions options;
+    std::function<void(const SearchInfo &)> on_iteration; // optional
+    void request_stop();
+    void ponderhit();
+    SearchResult go(Board &board, SearchLimits limits);
+    void start(Board &board, SearchLimits limits);
+    SearchResult run();
+    void print_thread_breakdown();
+};
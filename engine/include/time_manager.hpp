@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Turns the clock state of a "go" command into two deadlines:
+ *  - soft: checked between iterations, no new iteration is started after it.
+ *    It shrinks when the best move has been stable for several iterations and
+ *    grows when the score is dropping.
+ *  - hard: checked inside the search, which is abandoned when it passes.
+ *
+ * The search reads the clock only every POLL_INTERVAL nodes.
+ */
+class TimeManager
+{
+private:
+    static constexpr int64_t MOVE_OVERHEAD = 30; // ms kept back for communication lag
+    static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+    std::chrono::steady_clock::time_point start_time;
+    int64_t soft_limit = 0; // ms
+    int64_t hard_limit = 0; // ms
+    bool enabled = false;
+    bool fixed_time = false; // movetime: use all of it, no stability scaling
+
+public:
+    static constexpr long POLL_INTERVAL = 2048; // nodes between clock reads, a power of two
+
+    // time and increment of the side to move in ms, 0 if not given
+    void start(int64_t time, int64_t increment, int moves_to_go, int64_t move_time);
+
+    int64_t elapsed();
+    bool is_enabled();
+    int64_t get_soft_limit();
+    int64_t get_hard_limit();
+    bool hard_limit_reached();
+    bool soft_limit_reached(int stability, int score_drop);
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "common/types.hpp"
+
+enum Bound
+{
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT
+};
+
+/*
+ * Entry data packing:
+ *  0-23 -> move
+ *  24-39 -> score (signed 16 bit)
+ *  40-47 -> depth
+ *  48-49 -> bound
+ *  50-55 -> generation (age of the search that wrote it)
+ *
+ * The key is stored xor'd with the data so an entry torn by two threads writing
+ * at once fails the key check instead of returning another position's data.
+ */
+struct TTEntry
+{
+    std::atomic<u64> key;
+    std::atomic<u64> data;
+};
+
+/*
+ * Hash table shared by every search thread. Lookups and stores are lockless.
+ */
+class TranspositionTable
+{
+private:
+    static constexpr int BUCKET_SIZE = 4; // 4 x 16 byte entries = one cache line
+
+    std::unique_ptr<TTEntry[]> table;
+    size_t bucket_count = 0;
+    u64 generation = 0;
+
+public:
+    TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);
+    void clear();
+    void new_search();
+    bool probe(u64 key, int &move, int &score, int &depth, Bound &bound);
+    void store(u64 key, int move, int score, int depth, Bound bound);
+    int hashfull();
+};
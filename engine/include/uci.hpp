@@ -0,0 +1,63 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "board.hpp"
+#include "search.hpp"
+#include "transposition_table.hpp"
+
+/*
+ * UCI protocol front end, on three kinds of threads:
+ *  - a reader that only pulls lines off stdin. "stop", "ponderhit" and "quit"
+ *    take effect right there by flipping the search's atomic flags, then every
+ *    line is queued in order for the command loop.
+ *  - the command loop (the caller of loop()), which handles the queued
+ *    commands. It may block, e.g. "position" waits for a running search, but
+ *    that never delays a stop.
+ *  - the search, started by "go", which prints bestmove when it finishes.
+ *
+ * The reader also queues stop/ponderhit, so one that arrives before the "go"
+ * ahead of it has started (start() clears the flags) is applied again in order.
+ *
+ * The last position is kept together with the moves that were played on it:
+ * a "position" command that repeats them and adds new moves (what GUIs send
+ * every move) only plays the new ones instead of reloading the FEN.
+ */
+class Uci
+{
+private:
+    static constexpr const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    TranspositionTable tt;
+    Search search;
+    Board board;
+    string position_fen;
+    vector<string> position_moves;
+    std::thread search_thread;
+
+    std::thread reader_thread;
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<string> queue;
+
+    void read_input(istream &input);
+    string next_command();
+    void position(istringstream &input);
+    void go(istringstream &input);
+    void set_option(istringstream &input);
+    void wait_for_search();
+    void send_info(const SearchInfo &info);
+    static string score_to_string(int score);
+
+public:
+    Uci();
+    ~Uci();
+
+    void loop(istream &input = cin);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common/types.hpp"
+
+/*
+ * Zobrist keys used to hash a position.
+ * Keys are generated from a fixed seed so hashes are reproducible between runs.
+ */
+class Zobrist
+{
+private:
+    static u64 random_u64();
+    static void generate();
+    static u64 seed;
+
+public:
+    static u64 piece_keys[2][7][64];
+    static u64 enpassant_keys[8]; // indexed by file
+    static u64 castling_keys[16];
+    static u64 side_key;
+
+    static void init();
+};
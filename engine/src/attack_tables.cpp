@@ -1,3 +1,4 @@
+#include <mutex>
 #include "../include/attack_tables.hpp"
 
 u64 AttackTables::pawn_attack_table[2][64];
@@ -5,15 +6,22 @@ u64 AttackTables::knight_attack_table[64];
 u64 AttackTables::king_attack_table[64];
 u64 AttackTables::rook_attack_table[64][4096];
 u64 AttackTables::bishop_attack_table[64][512];
+u64 AttackTables::between_table[64][64];
+u64 AttackTables::line_table[64][64];
 u64 AttackTables::rook_magics[64];
 u64 AttackTables::bishop_magics[64];
 
 void AttackTables::init()
 {
-    init_pawn_tables();
-    init_knight_table();
-    init_king_table();
-    MagicBitboards::init_sliders(rook_magics, bishop_magics, rook_attack_table, bishop_attack_table);
+    // leaper tables are built with ^=, so a second init would wipe them; callers on other threads wait for the first
+    static std::once_flag once;
+    std::call_once(once, []()
+                   {
+        init_pawn_tables();
+        init_knight_table();
+        init_king_table();
+        MagicBitboards::init_sliders(rook_magics, bishop_magics, rook_attack_table, bishop_attack_table);
+        init_line_tables(); });
 }
 
 void AttackTables::init_pawn_tables()
@@ -82,6 +90,28 @@ void AttackTables::init_king_table()
     }
 }
 
+// built from the slider tables, so must run after the magics are initialised
+void AttackTables::init_line_tables()
+{
+    for (int a = 0; a < BOARD_SIZE; a++)
+    {
+        for (int b = 0; b < BOARD_SIZE; b++)
+        {
+            u64 a_bb = 1ULL << a, b_bb = 1ULL << b;
+            if (a != b && (rook_attacks((Square)a, 0) & b_bb))
+            {
+                line_table[a][b] = (rook_attacks((Square)a, 0) & rook_attacks((Square)b, 0)) | a_bb | b_bb;
+                between_table[a][b] = rook_attacks((Square)a, b_bb) & rook_attacks((Square)b, a_bb);
+            }
+            else if (a != b && (bishop_attacks((Square)a, 0) & b_bb))
+            {
+                line_table[a][b] = (bishop_attacks((Square)a, 0) & bishop_attacks((Square)b, 0)) | a_bb | b_bb;
+                between_table[a][b] = bishop_attacks((Square)a, b_bb) & bishop_attacks((Square)b, a_bb);
+            }
+        }
+    }
+}
+
 u64 AttackTables::pawn_attacks(Color color, Square square)
 {
     return pawn_attack_table[color][square];
@@ -116,4 +146,14 @@ u64 AttackTables::bishop_attacks(Square square, u64 occupancy)
 u64 AttackTables::queen_attacks(Square square, u64 occupancy)
 {
     return rook_attacks(square, occupancy) | bishop_attacks(square, occupancy);
-}
\ No newline at end of file
+}
+
+u64 AttackTables::between(Square a, Square b)
+{
+    return between_table[a][b];
+}
+
+u64 AttackTables::line(Square a, Square b)
+{
+    return line_table[a][b];
+}
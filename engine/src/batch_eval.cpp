@@ -0,0 +1,149 @@
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "../include/batch_eval.hpp"
+#include "../include/evaluation.hpp"
+
+static int piece_code(char c)
+{
+    static const string letters = " PNBRQK";
+    size_t type = letters.find((char)toupper(c));
+    if (c == ' ' || type == string::npos)
+    {
+        return -1;
+    }
+    return (isupper(c) ? WHITE : BLACK) * 8 + (int)type;
+}
+
+// parses the first four FEN (or EPD) fields, false if the piece placement is malformed
+bool PackedPosition::from_fen(const std::string &fen, PackedPosition &packed)
+{
+    packed = PackedPosition();
+    std::istringstream input(fen);
+    string placement, side = "w", castling = "-", enpassant = "-";
+    input >> placement >> side >> castling >> enpassant;
+
+    int square = 0, count = 0;
+    for (char c : placement)
+    {
+        if (c == '/')
+        {
+            continue;
+        }
+        if (isdigit(c))
+        {
+            square += c - '0';
+            continue;
+        }
+        int code = piece_code(c);
+        if (code < 0 || square >= 64 || count >= 32)
+        {
+            return false;
+        }
+        packed.occupancy |= 1ULL << square++;
+        packed.pieces[count / 2] |= code << (4 * (count % 2));
+        count++;
+    }
+    if (square != 64)
+    {
+        return false;
+    }
+
+    packed.side = side == "b" ? BLACK : WHITE;
+    for (char c : castling)
+    {
+        packed.castling |= c == 'K' ? WHITE_KINGSIDE : c == 'Q' ? WHITE_QUEENSIDE : c == 'k' ? BLACK_KINGSIDE : c == 'q' ? BLACK_QUEENSIDE : 0;
+    }
+    packed.enpassant = 64;
+    if (enpassant.size() == 2 && enpassant[0] >= 'a' && enpassant[0] <= 'h' && enpassant[1] >= '1' && enpassant[1] <= '8')
+    {
+        packed.enpassant = 8 * (8 - (enpassant[1] - '0')) + (enpassant[0] - 'a');
+    }
+    return packed.valid();
+}
+
+/*
+ * Whether a record is safe to unpack and evaluate: real piece types, one king
+ * a side, no pawns on the first or last rank. Binary files come from
+ * anywhere, so they are checked before anything indexes with their contents.
+ */
+bool PackedPosition::valid() const
+{
+    int count = __builtin_popcountll(occupancy);
+    if (count > 32 || side > BLACK || castling > 15 || enpassant > 64)
+    {
+        return false;
+    }
+    int kings[2] = {0, 0};
+    u64 back_ranks = 0xffULL | 0xffULL << 56;
+    u64 bitboard = occupancy;
+    for (int i = 0; i < count; i++, bitboard &= bitboard - 1)
+    {
+        int code = (pieces[i / 2] >> (4 * (i % 2))) & 0xf;
+        int type = code & 7;
+        if (type < PAWN || type > KING || (type == PAWN && (bitboard & -bitboard & back_ranks)))
+        {
+            return false;
+        }
+        kings[code >> 3] += type == KING;
+    }
+    return kings[WHITE] == 1 && kings[BLACK] == 1;
+}
+
+void PackedPosition::unpack(Board &board) const
+{
+    u64 pieces[2][7] = {};
+    int count = 0;
+    for (u64 bitboard = occupancy; bitboard; bitboard &= bitboard - 1)
+    {
+        int code = (this->pieces[count / 2] >> (4 * (count % 2))) & 0xf;
+        pieces[code >> 3][code & 7] |= bitboard & -bitboard;
+        count++;
+    }
+    board.set_position(pieces, (Color)side, castling, enpassant < 64 ? 1ULL << enpassant : 0);
+}
+
+BatchEvaluator::BatchEvaluator(int threads)
+{
+    thread_count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/*
+ * Positions are handed out in fixed blocks from a shared counter rather than
+ * one big slice per thread, so a slow block (deep endgame lookups, a busy
+ * core) doesn't leave the other workers idle at the end.
+ */
+void BatchEvaluator::evaluate(const PackedPosition *positions, size_t count, int *scores)
+{
+    constexpr size_t BLOCK = 1024;
+    std::atomic<size_t> next{0};
+    auto work = [&]()
+    {
+        Board board;
+        Evaluator evaluator;
+        size_t start;
+        while ((start = next.fetch_add(BLOCK)) < count)
+        {
+            size_t end = std::min(start + BLOCK, count);
+            for (size_t i = start; i < end; i++)
+            {
+                positions[i].unpack(board);
+                scores[i] = evaluator.evaluate(board);
+            }
+        }
+    };
+
+    int workers = (int)std::min<size_t>(thread_count, (count + BLOCK - 1) / BLOCK);
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
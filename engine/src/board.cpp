@@ -2,6 +2,7 @@
 #include <stack>   // for std::stack
 #include <cstring> // for memset
 #include <cstdint> // for uint64_t
+#include <algorithm>
 
 using namespace std;
 
@@ -15,8 +16,25 @@ Color Board::get_side()
     return side_to_move;
 }
 
+// the shared tables; each init() runs once however many boards there are and whichever thread gets there first
+Board::Board()
+{
+    AttackTables::init();
+    Zobrist::init();
+    PSQT::init();
+}
+
 void Board::load_fen(string fen)
 {
+    // reset position so a board can be reloaded
+    use_nnue = false;
+    memset(squares, 0, sizeof(squares));
+    memset(pieces, 0, sizeof(pieces));
+    memset(blockers, 0, sizeof(blockers));
+    state_stack = std::stack<BoardState>();
+    enpassant_square = 0ULL;
+    castling_rights = 0;
+
     int i = 0; // board index
     int j = 0;
     for (j = 0; i < 64 && fen[j] != ' '; ++j)
@@ -48,15 +66,30 @@ void Board::load_fen(string fen)
     }
 
     j++;
-    // 3. Castling Rights (Part 3 of FEN) - SKIPPING for now
+    // 3. Castling Rights (Part 3 of FEN)
     while (j < fen.length() && fen[j] == ' ')
     {
         j++;
     }
     while (j < fen.length() && fen[j] != ' ')
     {
+        switch (fen[j])
+        {
+        case 'K':
+            castling_rights |= WHITE_KINGSIDE;
+            break;
+        case 'Q':
+            castling_rights |= WHITE_QUEENSIDE;
+            break;
+        case 'k':
+            castling_rights |= BLACK_KINGSIDE;
+            break;
+        case 'q':
+            castling_rights |= BLACK_QUEENSIDE;
+            break;
+        }
         j++;
-    } // Skip the castling rights field
+    }
 
     // 4. En Passant Square (Part 4 of FEN)
     while (j < fen.length() && fen[j] == ' ')
@@ -77,14 +110,274 @@ void Board::load_fen(string fen)
             int fileValue = sq_str[0] - 'a';       // 'a' → 0, 'b' → 1, ..., 'h' → 7
             int rankValue = 8 - (sq_str[1] - '0'); // '1' → 7, '8' → 0
             Square sq_index = (Square)(8 * rankValue + fileValue);
-            cout << sq_str[0] << endl;
 
             // Store the en passant square as a single bitboard
             // Assuming enpassant_square is a u64 variable.
             enpassant_square = (1ULL << sq_index);
         }
     }
-    AttackTables::init();
+
+    init_derived_state();
+}
+
+/*
+ * Sets up a position from piece bitboards, for callers that already have
+ * the position in binary form and don't want to go through a FEN string.
+ */
+void Board::set_position(const u64 piece_bitboards[2][7], Color side, int castling, u64 enpassant)
+{
+    use_nnue = false;
+    memset(squares, 0, sizeof(squares));
+    memcpy(pieces, piece_bitboards, sizeof(pieces));
+    if (!state_stack.empty())
+    {
+        state_stack = std::stack<BoardState>();
+    }
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        blockers[color] = 0;
+        for (int type = PAWN; type <= KING; type++)
+        {
+            blockers[color] |= pieces[color][type];
+            for (u64 bitboard = pieces[color][type]; bitboard; bitboard &= bitboard - 1)
+            {
+                squares[__builtin_ctzll(bitboard)] = type;
+            }
+        }
+    }
+    side_to_move = side;
+    castling_rights = castling;
+    enpassant_square = enpassant;
+
+    init_derived_state();
+}
+
+// everything that follows from the pieces, side, castling rights and en passant square
+void Board::init_derived_state()
+{
+    hash = compute_hash();
+    pawn_key = compute_pawn_key();
+    psq = compute_psq();
+    phase = compute_phase();
+    material_signature = compute_material_signature();
+    update_check_info();
+
+    use_nnue = NNUE::loaded();
+    if (use_nnue)
+    {
+        accumulators.resize(1);
+        refresh_accumulator();
+    }
+}
+
+// saves what the move about to be made overwrites, for unmake_move to restore
+void Board::push_state(int move)
+{
+    BoardState state = {};
+    state.move = move;
+    state.hash = hash;
+    state.enpassant_square = enpassant_square;
+    state.castling_rights = castling_rights;
+    state.checkers = checkers;
+    memcpy(state.king_blockers, king_blockers, sizeof(king_blockers));
+    memcpy(state.check_squares, check_squares, sizeof(check_squares));
+    state_stack.push(state);
+}
+
+/*
+ * Caches what legality checks need: the checkers of the side to move and,
+ * for both kings, the pieces whose removal would expose the king to a slider
+ * (our pieces there are pinned, enemy pieces there can give discovered check).
+ */
+void Board::update_check_info()
+{
+    king_blockers[WHITE] = slider_blockers(WHITE);
+    king_blockers[BLACK] = slider_blockers(BLACK);
+    Square king_square = (Square)__builtin_ctzll(pieces[side_to_move][KING]);
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    checkers = attackers_to(king_square, blockers_all) & blockers[!side_to_move];
+
+    Square enemy_king_square = (Square)__builtin_ctzll(pieces[!side_to_move][KING]);
+    check_squares[PAWN] = AttackTables::pawn_attacks((Color)!side_to_move, enemy_king_square);
+    check_squares[KNIGHT] = AttackTables::knight_attacks(enemy_king_square);
+    check_squares[BISHOP] = AttackTables::bishop_attacks(enemy_king_square, blockers_all);
+    check_squares[ROOK] = AttackTables::rook_attacks(enemy_king_square, blockers_all);
+    check_squares[QUEEN] = check_squares[BISHOP] | check_squares[ROOK];
+    check_squares[KING] = 0;
+}
+
+// pieces standing alone between color's king and an enemy slider aimed at it
+u64 Board::slider_blockers(Color color)
+{
+    Square king_square = (Square)__builtin_ctzll(pieces[color][KING]);
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    u64 snipers = (AttackTables::rook_attacks(king_square, 0) & (pieces[!color][ROOK] | pieces[!color][QUEEN])) |
+                  (AttackTables::bishop_attacks(king_square, 0) & (pieces[!color][BISHOP] | pieces[!color][QUEEN]));
+    u64 result = 0;
+    while (snipers)
+    {
+        u64 between = AttackTables::between(king_square, (Square)__builtin_ctzll(snipers)) & blockers_all;
+        if (between && !(between & (between - 1)))
+        {
+            result |= between;
+        }
+        snipers &= snipers - 1;
+    }
+    return result;
+}
+
+u64 Board::get_checkers()
+{
+    return checkers;
+}
+
+u64 Board::get_king_blockers(Color color)
+{
+    return king_blockers[color];
+}
+
+u64 Board::compute_hash()
+{
+    u64 key = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = PAWN; type <= KING; type++)
+        {
+            u64 bitboard = pieces[color][type];
+            while (bitboard)
+            {
+                key ^= Zobrist::piece_keys[color][type][__builtin_ctzll(bitboard)];
+                bitboard &= bitboard - 1;
+            }
+        }
+    }
+    key ^= Zobrist::castling_keys[castling_rights];
+    if (enpassant_square)
+    {
+        key ^= Zobrist::enpassant_keys[__builtin_ctzll(enpassant_square) & 7];
+    }
+    if (side_to_move == BLACK)
+    {
+        key ^= Zobrist::side_key;
+    }
+    return key;
+}
+
+u64 Board::get_hash()
+{
+    return hash;
+}
+
+u64 Board::get_pawn_key()
+{
+    return pawn_key;
+}
+
+u64 Board::compute_pawn_key()
+{
+    u64 key = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        u64 bitboard = pieces[color][PAWN];
+        while (bitboard)
+        {
+            key ^= Zobrist::piece_keys[color][PAWN][__builtin_ctzll(bitboard)];
+            bitboard &= bitboard - 1;
+        }
+    }
+    return key;
+}
+
+// the move that led to this position, 0 at the root
+int Board::last_move()
+{
+    return state_stack.empty() ? 0 : state_stack.top().move;
+}
+
+Score Board::get_psq()
+{
+    return psq;
+}
+
+int Board::get_phase()
+{
+    return phase;
+}
+
+u64 Board::get_material_signature()
+{
+    return material_signature;
+}
+
+int Board::material_count(Color color, PieceType type)
+{
+    return PSQT::signature_count(material_signature, color, type);
+}
+
+// full scans for phase and material signature, used by load_fen and to check the incremental versions
+int Board::compute_phase()
+{
+    int result = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = KNIGHT; type <= QUEEN; type++)
+        {
+            result += PSQT::PHASE_WEIGHTS[type] * __builtin_popcountll(pieces[color][type]);
+        }
+    }
+    return result;
+}
+
+u64 Board::compute_material_signature()
+{
+    u64 result = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = PAWN; type <= QUEEN; type++)
+        {
+            result += PSQT::signature_unit(color, type) * __builtin_popcountll(pieces[color][type]);
+        }
+    }
+    return result;
+}
+
+// full scan, what the incremental psq has to match
+Score Board::compute_psq()
+{
+    Score score = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = PAWN; type <= KING; type++)
+        {
+            u64 bitboard = pieces[color][type];
+            while (bitboard)
+            {
+                score += PSQT::table[color][type][__builtin_ctzll(bitboard)];
+                bitboard &= bitboard - 1;
+            }
+        }
+    }
+    return score;
+}
+
+u64 Board::get_pieces(Color color, PieceType type)
+{
+    return pieces[color][type];
+}
+
+u64 Board::get_occupancy(Color color)
+{
+    return blockers[color];
+}
+
+int Board::non_pawn_material(Color color)
+{
+    int material = 0;
+    for (int type = KNIGHT; type <= QUEEN; type++)
+    {
+        material += PIECE_VALUES[type] * __builtin_popcountll(pieces[color][type]);
+    }
+    return material;
 }
 
 int Board::type_of(char c)
@@ -232,6 +525,44 @@ int Board::get_piece_at_square(Square sq)
     return NO_PIECE;
 }
 
+/*
+ * Passes the turn for null-move pruning: flips the side to move and clears
+ * the en passant square, leaving the pieces alone. The state is pushed with
+ * move 0 so last_move() reports no previous move. Must not be called in check,
+ * and must be undone with unmake_null_move rather than unmake_move.
+ */
+void Board::make_null_move()
+{
+    push_state(0);
+
+    if (enpassant_square)
+    {
+        hash ^= Zobrist::enpassant_keys[__builtin_ctzll(enpassant_square) & 7];
+        enpassant_square = 0;
+    }
+    side_to_move = side_to_move == WHITE ? BLACK : WHITE;
+    hash ^= Zobrist::side_key;
+    update_check_info();
+
+    if (use_nnue)
+    {
+        delta.count = 0; // nothing moved, the update is a plain copy
+        push_accumulator();
+    }
+}
+
+void Board::unmake_null_move()
+{
+    BoardState &state = state_stack.top();
+    hash = state.hash;
+    enpassant_square = state.enpassant_square;
+    checkers = state.checkers;
+    memcpy(check_squares, state.check_squares, sizeof(check_squares));
+    state_stack.pop();
+
+    side_to_move = side_to_move == WHITE ? BLACK : WHITE;
+}
+
 /*
  * Move encoding:
  *  0-5 -> start square
@@ -252,9 +583,141 @@ int Board::get_piece_at_square(Square sq)
  *      100 -> queenside castle
  */
 
+// castling rights that survive a piece leaving or landing on each square
+static const int castling_rights_mask[64] = {
+    ~BLACK_QUEENSIDE & 15, 15, 15, 15, ~(BLACK_KINGSIDE | BLACK_QUEENSIDE) & 15, 15, 15, ~BLACK_KINGSIDE & 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    ~WHITE_QUEENSIDE & 15, 15, 15, 15, ~(WHITE_KINGSIDE | WHITE_QUEENSIDE) & 15, 15, 15, ~WHITE_KINGSIDE & 15};
+
+void Board::put_piece(Color color, PieceType type, Square square)
+{
+    pieces[color][type] |= 1ULL << square;
+    blockers[color] |= 1ULL << square;
+    squares[square] = type;
+    hash ^= Zobrist::piece_keys[color][type][square];
+    psq += PSQT::table[color][type][square];
+    if (type == PAWN)
+    {
+        pawn_key ^= Zobrist::piece_keys[color][PAWN][square];
+    }
+    phase += PSQT::PHASE_WEIGHTS[type];
+    material_signature += PSQT::signature_unit(color, type);
+    if (use_nnue)
+    {
+        record_delta(1, color, type, square);
+    }
+}
+
+void Board::remove_piece(Color color, PieceType type, Square square)
+{
+    pieces[color][type] &= ~(1ULL << square);
+    blockers[color] &= ~(1ULL << square);
+    squares[square] = NO_PIECE;
+    hash ^= Zobrist::piece_keys[color][type][square];
+    psq -= PSQT::table[color][type][square];
+    if (type == PAWN)
+    {
+        pawn_key ^= Zobrist::piece_keys[color][PAWN][square];
+    }
+    phase -= PSQT::PHASE_WEIGHTS[type];
+    material_signature -= PSQT::signature_unit(color, type);
+    if (use_nnue)
+    {
+        record_delta(-1, color, type, square);
+    }
+}
+
+void Board::record_delta(int sign, Color color, PieceType type, Square square)
+{
+    delta.sign[delta.count] = sign;
+    delta.color[delta.count] = color;
+    delta.type[delta.count] = type;
+    delta.square[delta.count] = square;
+    delta.count++;
+}
+
+// accumulator for the entry make_move or make_null_move just pushed, from the one below it
+void Board::push_accumulator()
+{
+    size_t ply = state_stack.size();
+    if (accumulators.size() <= ply)
+    {
+        accumulators.resize(ply + 1);
+    }
+    NNUE::update(accumulators[ply - 1], accumulators[ply], delta, pieces);
+}
+
+/*
+ * Brings the board in line with the network after one was loaded, replaced
+ * or unloaded. The moves made since the position was set up are taken back
+ * and replayed, so every accumulator on the stack is rebuilt from the new
+ * weights, not just the current one.
+ */
+void Board::sync_network()
+{
+    vector<int> moves;
+    use_nnue = false;
+    while (!state_stack.empty())
+    {
+        moves.push_back(state_stack.top().move);
+        if (state_stack.top().move)
+        {
+            unmake_move();
+        }
+        else
+        {
+            unmake_null_move();
+        }
+    }
+
+    use_nnue = NNUE::loaded();
+    accumulators.clear();
+    if (use_nnue)
+    {
+        accumulators.resize(1);
+        refresh_accumulator();
+    }
+    for (auto move = moves.rbegin(); move != moves.rend(); ++move)
+    {
+        if (*move)
+        {
+            make_move(*move);
+        }
+        else
+        {
+            make_null_move();
+        }
+    }
+}
+
+bool Board::nnue_enabled()
+{
+    return use_nnue;
+}
+
+const Accumulator &Board::get_accumulator()
+{
+    return accumulators[state_stack.size()];
+}
+
+void Board::refresh_accumulator()
+{
+    NNUE::refresh(accumulators[state_stack.size()], WHITE, pieces);
+    NNUE::refresh(accumulators[state_stack.size()], BLACK, pieces);
+}
+
 // change return type to void later
 bool Board::make_move(Square start, Square target, Color turn, vector<int> legal_moves)
 {
+    if (turn != side_to_move)
+    {
+        return false; // the moves only apply to the side to move
+    }
     int valid_move = 0;
 
     for (int move : legal_moves)
@@ -270,101 +733,169 @@ bool Board::make_move(Square start, Square target, Color turn, vector<int> legal
     if (valid_move == 0)
         return false;
 
-    PieceType piece_on_start = (PieceType)squares[start];
-    PieceType pt = (PieceType)((valid_move & (0b111 << 12)) >> 12);
+    return make_move(valid_move);
+}
+
+/*
+ * Plays a move produced by generate_legal_moves. The move is not validated.
+ */
+bool Board::make_move(int move)
+{
+    Color turn = side_to_move;
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    PieceType pt = (PieceType)((move >> 12) & 0b111);
+    PieceType promoted_piece = (PieceType)((move >> 18) & 0b111);
+    int special_moves_flag = (move >> 21) & 0b111;
 
+    PieceType captured_piece_type = NO_PIECE;
     if ((1ULL << target) & blockers[!turn])
     {
-        // Get the captured piece's type using a helper function or bitmask
-        PieceType captured_piece_type = (PieceType)(get_piece_at_square(target) & 0b111);
+        captured_piece_type = (PieceType)squares[target];
+    }
+    else if (special_moves_flag == 2) // enpassant capture
+    {
+        captured_piece_type = PAWN;
+    }
+    move = (move & ~(0b111 << 15)) | (captured_piece_type << 15);
+    delta.count = 0;
 
-        valid_move |= (captured_piece_type << 15);
+    push_state(move);
 
-        // Remove the captured piece from the opponent's bitboards
-        pieces[!turn][captured_piece_type] &= ~(1ULL << target);
-        blockers[!turn] &= ~(1ULL << target);
+    if (special_moves_flag == 2) // handle enpassant capture
+    {
+        int enpassant_capture = turn == WHITE ? target + 8 : target - 8;
+        remove_piece((Color)!turn, PAWN, (Square)enpassant_capture);
+    }
+    else if (captured_piece_type)
+    {
+        remove_piece((Color)!turn, captured_piece_type, target);
     }
 
-    // Remove the piece from its starting square
-    pieces[turn][pt] &= ~(1ULL << start);
-    blockers[turn] &= ~(1ULL << start);
+    // move the piece, swapping in the promotion piece if there is one
+    remove_piece(turn, pt, start);
+    put_piece(turn, promoted_piece ? promoted_piece : pt, target);
 
-    // Place the piece on the target square
-    pieces[turn][pt] |= 1ULL << target;
-    blockers[turn] |= 1ULL << target;
+    if (special_moves_flag == 3) // kingside castle, rook jumps from h-file to f-file
+    {
+        remove_piece(turn, ROOK, (Square)(target + 1));
+        put_piece(turn, ROOK, (Square)(target - 1));
+    }
+    else if (special_moves_flag == 4) // queenside castle, rook jumps from a-file to d-file
+    {
+        remove_piece(turn, ROOK, (Square)(target - 2));
+        put_piece(turn, ROOK, (Square)(target + 1));
+    }
 
-    // handle special moves
-    int special_moves_flag = (valid_move & (0b111 << 21)) >> 21;
+    hash ^= Zobrist::castling_keys[castling_rights];
+    castling_rights &= castling_rights_mask[start] & castling_rights_mask[target];
+    hash ^= Zobrist::castling_keys[castling_rights];
 
-    // cout << "special_moves_flag: " << special_moves_flag << endl;
-    if (special_moves_flag == 2) // handle enpassant capture
+    if (enpassant_square)
     {
-        int enpassant_capture = turn == WHITE ? target + 8 : target - 8;
-        pieces[!turn][PAWN] &= ~(1ULL << enpassant_capture);
-        blockers[!turn] &= ~(1ULL << enpassant_capture);
-        valid_move |= (PAWN << 15); // put PAWN as captured piece
+        hash ^= Zobrist::enpassant_keys[__builtin_ctzll(enpassant_square) & 7];
     }
-    else if ((valid_move & (0b111 << 18)) >> 18) // handle promotion
+    enpassant_square = special_moves_flag == 1 ? 1ULL << ((start + target) >> 1) : 0ULL;
+    if (enpassant_square)
     {
-        pieces[turn][PAWN] &= ~(1ULL << target);                              // remove pawn from promotion square
-        pieces[turn][(valid_move & (0b111 << 18)) >> 18] |= (1ULL << target); // add promotion piece
+        hash ^= Zobrist::enpassant_keys[__builtin_ctzll(enpassant_square) & 7];
     }
-    // handle rest later
 
     side_to_move = side_to_move == WHITE ? BLACK : WHITE;
+    hash ^= Zobrist::side_key;
+    update_check_info();
+    if (use_nnue)
+    {
+        push_accumulator();
+    }
 
-    // print_move_encoding("move", valid_move);
-    //  push move to move stack
-    move_stack.push(valid_move);
+#ifdef EVAL_DEBUG
+    if (psq != compute_psq() || phase != compute_phase() || material_signature != compute_material_signature() ||
+        pawn_key != compute_pawn_key())
+    {
+        cerr << "incremental eval out of sync after " << move_to_string(move) << endl;
+        abort();
+    }
+    if (use_nnue)
+    {
+        Accumulator fresh;
+        NNUE::refresh(fresh, WHITE, pieces);
+        NNUE::refresh(fresh, BLACK, pieces);
+        if (memcmp(&fresh, &get_accumulator(), sizeof(fresh)) != 0)
+        {
+            cerr << "accumulator out of sync after " << move_to_string(move) << endl;
+            abort();
+        }
+    }
+#endif
 
     return true;
 }
 
 bool Board::unmake_move()
 {
-    if (move_stack.size() == 0)
+    if (state_stack.size() == 0)
     {
         return false;
     }
 
-    int move = move_stack.top();
+    BoardState state = state_stack.top();
+    int move = state.move;
+    Color turn = side_to_move == WHITE ? BLACK : WHITE; // side that made the move
 
     Square start = (Square)(move & 0x3f);
     Square target = (Square)((move & 0xfc0) >> 6);
-    PieceType moved_piece = (PieceType)(get_piece_at_square(target) & 0b111);
+    PieceType moved_piece = (PieceType)((move & (0b111 << 12)) >> 12);
     PieceType captured_piece = (PieceType)((move & (0b111 << 15)) >> 15);
     PieceType promoted_piece = (PieceType)((move & (0b111 << 18)) >> 18);
     int special_moves_flag = (move & (0b111 << 21)) >> 21;
+    delta.count = 0; // the accumulator below is still intact, nothing to record
 
-    // remove piece that just moved from target square
-    pieces[!side_to_move][moved_piece] &= ~(1ULL << target);
-    blockers[!side_to_move] &= ~(1ULL << target);
+    // move the piece back to its start square (as a pawn if it promoted)
+    remove_piece(turn, promoted_piece ? promoted_piece : moved_piece, target);
+    put_piece(turn, moved_piece, start);
 
-    // re-add piece that just moved to start square
-    pieces[!side_to_move][moved_piece] |= (1ULL << start);
-    blockers[!side_to_move] |= (1ULL << start);
+    if (special_moves_flag == 3)
+    {
+        remove_piece(turn, ROOK, (Square)(target - 1));
+        put_piece(turn, ROOK, (Square)(target + 1));
+    }
+    else if (special_moves_flag == 4)
+    {
+        remove_piece(turn, ROOK, (Square)(target + 1));
+        put_piece(turn, ROOK, (Square)(target - 2));
+    }
 
     if (special_moves_flag == 2) // if last move was an enpassant capture
     {
-        target = (Square)(side_to_move == WHITE ? target - 8 : target + 8); // change target square to be where captured pawn should be re-added
+        target = (Square)(turn == WHITE ? target + 8 : target - 8); // change target square to be where captured pawn should be re-added
     }
 
     // add captured piece back to bitboard(s) if there is one
     if (captured_piece)
     {
-        pieces[side_to_move][captured_piece] |= (1ULL << target);
-        blockers[side_to_move] |= (1ULL << target);
+        put_piece(side_to_move, captured_piece, target);
     }
 
-    if (promoted_piece) // if last move was promotion
-    {
-        pieces[!side_to_move][promoted_piece] &= ~(1ULL << start); // remove promoted piece bit from its bitboard
-        pieces[!side_to_move][PAWN] |= (1ULL << start);            // add pawn back to board
-    }
+    hash = state.hash;
+    enpassant_square = state.enpassant_square;
+    castling_rights = state.castling_rights;
+    checkers = state.checkers;
+    king_blockers[WHITE] = state.king_blockers[WHITE];
+    king_blockers[BLACK] = state.king_blockers[BLACK];
+    memcpy(check_squares, state.check_squares, sizeof(check_squares));
+    state_stack.pop();
 
-    move_stack.pop();
+    side_to_move = turn;
 
-    side_to_move = side_to_move == WHITE ? BLACK : WHITE;
+#ifdef EVAL_DEBUG
+    if (psq != compute_psq() || phase != compute_phase() || material_signature != compute_material_signature() ||
+        pawn_key != compute_pawn_key())
+    {
+        cerr << "incremental eval out of sync after undoing " << move_to_string(move) << endl;
+        abort();
+    }
+#endif
 
     return true;
 }
@@ -388,146 +919,137 @@ bool Board::unmake_move()
  *      100 -> queenside castle
  */
 
-vector<int> Board::generate_legal_moves(Color color)
+/*
+ * Fills in the checkmask (squares that block or capture a checker, all 1's
+ * when not in check), whether the king is in double check, and the ray each
+ * pinned piece is restricted to (all 1's for unpinned pieces).
+ * Built from the cached checkers and king blockers.
+ */
+void Board::generate_check_and_pin_masks(Color color, u64 &checkmask, bool &double_check, u64 pin_masks[64])
 {
-    vector<int> legal_moves;
-    u64 bitboard;
-    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
-    u64 empty = ~blockers_all;
-    Color opposite_color = color == WHITE ? BLACK : WHITE;
-
-    /*** generate check mask and if there is single/double check ***/
-    u64 checkmask = 0, check_square = 0;
-    bool double_check = false;
     Square king_square = (Square)__builtin_ctzll(pieces[color][KING]);
+    u64 color_checkers = color == side_to_move ? checkers : attackers_to(king_square, blockers[WHITE] | blockers[BLACK]) & blockers[!color];
 
-    checkmask |= ((AttackTables::pawn_attacks(color, king_square) & pieces[opposite_color][PAWN]) ? AttackTables::pawn_attacks(color, king_square) & pieces[opposite_color][PAWN] : 0); // if pawn attacking current king
-
-    checkmask |= ((AttackTables::knight_attacks(king_square) & pieces[opposite_color][KNIGHT]) ? AttackTables::knight_attacks(king_square) & pieces[opposite_color][KNIGHT] : 0); // if knight attacking current king
-
-    check_square = AttackTables::bishop_attacks(king_square, blockers_all) & pieces[opposite_color][BISHOP];
-    checkmask |= (check_square ? AttackTables::bishop_attacks(king_square, blockers_all) & AttackTables::bishop_attacks((Square)__builtin_ctzll(check_square), blockers_all) | check_square : 0); // if bishop attacking current king
-
-    check_square = AttackTables::rook_attacks(king_square, blockers_all) & pieces[opposite_color][ROOK];
-    checkmask |= (check_square ? AttackTables::rook_attacks(king_square, blockers_all) & AttackTables::rook_attacks((Square)__builtin_ctzll(check_square), blockers_all) | check_square : 0); // if rook attacking current king
+    double_check = __builtin_popcountll(color_checkers) > 1;
+    if (double_check)
+    {
+        checkmask = 0; // only the king can move, pins don't matter
+        return;
+    }
+    checkmask = color_checkers ? AttackTables::between(king_square, (Square)__builtin_ctzll(color_checkers)) | color_checkers : ~0ULL;
 
-    check_square = AttackTables::bishop_attacks(king_square, blockers_all) & pieces[opposite_color][QUEEN];
-    checkmask |= check_square ? AttackTables::bishop_attacks(king_square, blockers_all) & AttackTables::bishop_attacks((Square)__builtin_ctzll(check_square), blockers_all) | check_square : 0; // if queen attacking current king
+    /*** generate pins ***/
+    memset(pin_masks, 0xff, 64 * sizeof(u64));
+    u64 pinned = king_blockers[color] & blockers[color];
+    while (pinned)
+    {
+        int square = __builtin_ctzll(pinned);
+        pin_masks[square] = AttackTables::line(king_square, (Square)square);
+        pinned &= pinned - 1;
+    }
+}
 
-    check_square = AttackTables::rook_attacks(king_square, blockers_all) & pieces[opposite_color][QUEEN];
-    checkmask |= check_square ? AttackTables::rook_attacks(king_square, blockers_all) & AttackTables::rook_attacks((Square)__builtin_ctzll(check_square), blockers_all) | check_square : 0; // if queen attacking current king
+vector<int> Board::generate_legal_moves(Color color)
+{
+    return generate_moves(color, GEN_ALL);
+}
 
-    if (__builtin_popcountll(checkmask & blockers[opposite_color]) > 1) // if double check
+/*
+ * GEN_ALL generates every legal move.
+ * GEN_CAPTURES only generates moves landing on an enemy piece, the enpassant
+ * square or the promotion rank (queen promotions only), for quiescence search.
+ * GEN_QUIETS generates everything GEN_CAPTURES leaves out: non-captures,
+ * castling and under-promotions, so the two together are GEN_ALL.
+ * GEN_QUIET_CHECKS is the subset of GEN_QUIETS (minus promotions) that gives
+ * check, found by masking each piece's targets with its check squares rather
+ * than generating every quiet and filtering. Only valid for the side to move.
+ * When the side to move is in check the work goes to generate_evasions,
+ * unless use_evasions is false (kept for benchmarking the general path).
+ */
+vector<int> Board::generate_moves(Color color, GenType type, bool use_evasions)
+{
+    if (use_evasions && checkers && color == side_to_move && type != GEN_QUIET_CHECKS)
     {
-        double_check = true;
+        return generate_evasions(color, type);
     }
-    checkmask = checkmask == 0 ? ~0 : checkmask; // toggle checkmask to be all 1's if no checks
 
-    // print_bitboard("checkmask", checkmask);
+    vector<int> moves;
+    u64 bitboard;
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    u64 empty = ~blockers_all;
+    u64 targets = type == GEN_CAPTURES ? blockers[!color] : (type == GEN_QUIETS || type == GEN_QUIET_CHECKS) ? empty : ~blockers[color];
+    Square king_square = (Square)__builtin_ctzll(pieces[color][KING]);
+
+    u64 checkmask, pin_masks[64];
+    bool double_check;
+    generate_check_and_pin_masks(color, checkmask, double_check, pin_masks);
 
     // generate king legal moves
     bitboard = pieces[color][KING];
     while (bitboard)
     {
         int start = __builtin_ctzll(bitboard);
-        u64 enemy_attacks = get_attacks(color == WHITE ? BLACK : WHITE);
-        // handle castling
-        bool king_in_check = (enemy_attacks & (1ULL << king_square)) != 0;
-
-        // 2. King-side Castling Check
-        bool kingside_clear = (castle_masks[color][KINGSIDE] & blockers_all) == 0;
-        bool kingside_safe = (castle_masks[color][KINGSIDE] & enemy_attacks) == 0;
-
-        cout << "king in check: " << king_in_check << endl;
-        cout << "kingside safe: " << kingside_safe << endl;
-        cout << "kingside clear: " << kingside_clear << endl;
-        bool can_kingside_castle = !king_in_check && kingside_clear && kingside_safe;
-
-        // 3. Queen-side Castling Check
-        bool queenside_clear = (castle_masks[color][QUEENSIDE] & blockers_all) == 0;
-        bool queenside_safe = (castle_masks[color][QUEENSIDE] & enemy_attacks) == 0;
-
-        bool can_queenside_castle = !king_in_check && queenside_clear && queenside_safe;
-        print_bitboard("kingside castle mask", castle_masks[color][KINGSIDE]);
-        print_bitboard("kingside blockers", (castle_masks[color][KINGSIDE] & blockers_all));
-        print_bitboard("kingside attacks", (castle_masks[color][KINGSIDE] & enemy_attacks));
-        cout << "kingside castle: " << can_kingside_castle << endl;
-        cout << "queenside castle: " << can_queenside_castle << endl;
-
-        u64 kingside_castle = can_kingside_castle ? castle_square[color][KINGSIDE] : 0ULL;
-        u64 queenside_castle = can_queenside_castle ? castle_square[color][QUEENSIDE] : 0ULL;
-
-        u64 attacks = (AttackTables::king_attacks((Square)start) & ~blockers[color] & ~enemy_attacks);
+        u64 attacks = AttackTables::king_attacks((Square)start) & targets;
+        if (type == GEN_QUIET_CHECKS)
+        {
+            attacks &= quiet_check_targets(color, KING, (Square)start);
+        }
         while (attacks)
         {
+            // test each target square with the king lifted off the board, so sliders see through it
             int target = __builtin_ctzll(attacks); // compiler instruction to get position of rightmost set bit
-            legal_moves.push_back(KING << 12 | target << 6 | start);
+            if (!(attackers_to((Square)target, blockers_all ^ (1ULL << start)) & blockers[!color]))
+            {
+                moves.push_back(squares[target] << 15 | KING << 12 | target << 6 | start);
+            }
             attacks &= attacks - 1;
         }
-        /* TODO: FINISH CASTLING LOGIC */
+        if (type == GEN_CAPTURES || checkmask != ~0ULL)
+        {
+            bitboard &= bitboard - 1;
+            continue; // no castling out of check
+        }
+
+        // handle castling
+        bool kingside_clear = (castle_masks[color][KINGSIDE] & blockers_all) == 0;
+        bool can_kingside_castle = (castling_rights & castle_rights_for[color][KINGSIDE]) && kingside_clear &&
+                                   !squares_attacked(castle_safe_masks[color][KINGSIDE], (Color)!color);
+
+        bool queenside_clear = (castle_masks[color][QUEENSIDE] & blockers_all) == 0;
+        bool can_queenside_castle = (castling_rights & castle_rights_for[color][QUEENSIDE]) && queenside_clear &&
+                                    !squares_attacked(castle_safe_masks[color][QUEENSIDE], (Color)!color);
+
         int special_moves_flag = 0;
         if (can_kingside_castle)
         {
             special_moves_flag = 3;
-            legal_moves.push_back(special_moves_flag << 21 | __builtin_ctz(kingside_castle) << 6 | king_square);
+            int castle = special_moves_flag << 21 | KING << 12 | __builtin_ctzll(castle_square[color][KINGSIDE]) << 6 | king_square;
+            if (type != GEN_QUIET_CHECKS || gives_check(castle))
+            {
+                moves.push_back(castle);
+            }
         }
         if (can_queenside_castle)
         {
             special_moves_flag = 4;
-            legal_moves.push_back(special_moves_flag << 21 | __builtin_ctz(kingside_castle) << 6 | king_square);
+            int castle = special_moves_flag << 21 | KING << 12 | __builtin_ctzll(castle_square[color][QUEENSIDE]) << 6 | king_square;
+            if (type != GEN_QUIET_CHECKS || gives_check(castle))
+            {
+                moves.push_back(castle);
+            }
         }
         bitboard &= bitboard - 1;
     }
     if (double_check)
     {
-        return legal_moves;
-    }
-
-    /*** generate pins ***/
-    u64 pin_masks[64];
-    memset(pin_masks, 0xff, sizeof(pin_masks));
-    u64 temp_board = pieces[color][KING] | blockers[opposite_color];
-    u64 pin_square = 0, pin_hv = 0, pin_diag = 0, temp_pieces = 0, pin_ray = 0;
-
-    // populate pin_mask array
-    u64 sliders_bitboard = pieces[!color][BISHOP] | pieces[!color][QUEEN];
-    while (sliders_bitboard)
-    {
-        pin_square = AttackTables::bishop_attacks(king_square, sliders_bitboard) & (1ULL << __builtin_ctzll(sliders_bitboard));
-        pin_ray = pin_square ? AttackTables::bishop_attacks(king_square, sliders_bitboard) & AttackTables::bishop_attacks((Square)__builtin_ctzll(pin_square), temp_board) | pin_square : 0ULL;
-        int num_blockers_on_mask = __builtin_popcountll((pin_ray & blockers_all) ^ pin_square);
-        if (num_blockers_on_mask == 1 && (pin_ray & blockers[color]))
-        {
-            pin_masks[__builtin_ctzll(pin_ray & blockers[color])] = pin_ray;
-        }
-        sliders_bitboard &= sliders_bitboard - 1;
-    }
-
-    sliders_bitboard = pieces[!color][ROOK] | pieces[!color][QUEEN];
-    while (sliders_bitboard)
-    {
-        pin_square = AttackTables::rook_attacks(king_square, sliders_bitboard) & (1ULL << __builtin_ctzll(sliders_bitboard));
-        pin_ray = pin_square ? AttackTables::rook_attacks(king_square, sliders_bitboard) & AttackTables::rook_attacks((Square)__builtin_ctzll(pin_square), temp_board) | pin_square : 0ULL;
-        int num_blockers_on_mask = __builtin_popcountll((pin_ray & blockers_all) ^ pin_square);
-        if (num_blockers_on_mask == 1 && (pin_ray & blockers[color]))
-        {
-            pin_masks[__builtin_ctzll(pin_ray & blockers[color])] = pin_ray;
-        }
-        sliders_bitboard &= sliders_bitboard - 1;
+        return moves;
     }
 
-    int prev_move = move_stack.size() ? move_stack.top() : 0;
-
     // generate pawn legal moves
+    u64 promotion_rank = 0xffULL | (0xffULL << 56);
     bitboard = pieces[color][PAWN];
     while (bitboard)
     {
-
-        if (prev_move)
-        {
-            enpassant_square = (((0b001 << 21) & prev_move) != 0) ? 1ULL << (((0x3f & prev_move) + ((0xfc0 & prev_move) >> 6)) >> 1) : 0ULL;
-        }
-
         int start = __builtin_ctzll(bitboard);
         u64 single_push, double_push, double_push_rank;
         if (color == WHITE)
@@ -541,34 +1063,59 @@ vector<int> Board::generate_legal_moves(Color color)
             single_push = ((1ULL << start) << 8) & empty;
             double_push_rank = (0xffULL << 24);
             double_push = ((single_push & (double_push_rank >> 8)) << 8) & empty; // check if black pawn on 6th rank
-            // print_bitboard("double push", double_push);
         }
         u64 attacks = AttackTables::pawn_attacks(color, (Square)start);
         u64 normal_captures = attacks & blockers[!color];
         u64 enpassant_capture = attacks & enpassant_square;
-        if (enpassant_capture) // check enpassant capture special case for rooks/queens
+        if (enpassant_capture)
         {
+            // the capture is only legal if it resolves any check and doesn't expose the king
+            // on the rank (both pawns leave it) or the diagonal (the captured pawn leaves it)
             u64 enpassant_sq_capture = color == WHITE ? enpassant_capture << 8 : enpassant_capture >> 8;
-            u64 is_attack = AttackTables::rook_attacks(king_square, (blockers_all & ~((1ULL << start) | enpassant_sq_capture))) & (pieces[!color][ROOK] | pieces[!color][QUEEN]);
-            if (is_attack)
+            u64 occupancy_after = (blockers_all & ~((1ULL << start) | enpassant_sq_capture)) | enpassant_capture;
+            u64 is_attack = (AttackTables::rook_attacks(king_square, occupancy_after) & (pieces[!color][ROOK] | pieces[!color][QUEEN])) |
+                            (AttackTables::bishop_attacks(king_square, occupancy_after) & (pieces[!color][BISHOP] | pieces[!color][QUEEN]));
+            if (is_attack || !(checkmask & (enpassant_capture | enpassant_sq_capture)))
             {
                 enpassant_capture = 0ULL;
             }
         }
-        u64 moves = (single_push | double_push | normal_captures | enpassant_capture) & (checkmask | enpassant_capture) & pin_masks[start];
+        u64 pawn_moves = (((single_push | double_push | normal_captures) & checkmask) | enpassant_capture) & pin_masks[start];
+        if (type == GEN_CAPTURES)
+        {
+            pawn_moves &= blockers[!color] | enpassant_capture | promotion_rank;
+        }
+        else if (type == GEN_QUIETS)
+        {
+            pawn_moves &= (empty & ~enpassant_capture) | promotion_rank;
+        }
+        else if (type == GEN_QUIET_CHECKS)
+        {
+            pawn_moves &= empty & ~enpassant_capture & ~promotion_rank & quiet_check_targets(color, PAWN, (Square)start);
+        }
 
-        while (moves)
+        while (pawn_moves)
         {
-            int target = __builtin_ctzll(moves);
+            int target = __builtin_ctzll(pawn_moves);
             int is_double_push = ((1ULL << target) & double_push_rank) && double_push;
-            int is_enpassant_capture = ((1ULL << target) & enpassant_square) != 0 ? 0b010 : 0;
+            int is_enpassant_capture = ((1ULL << target) & enpassant_capture) != 0 ? 0b010 : 0;
             int special_flags = is_double_push | is_enpassant_capture;
-            int promotion_piece = (((1ULL << target) & 0xff) || ((1ULL << target) & (0xffULL << 56)))
-                                      ? QUEEN
-                                      : NO_PIECE;
-            int legal_move = special_flags << 21 | promotion_piece << 18 | PAWN << 12 | target << 6 | start;
-            legal_moves.push_back(legal_move);
-            moves &= moves - 1;
+            int legal_move = special_flags << 21 | squares[target] << 15 | PAWN << 12 | target << 6 | start;
+            if ((1ULL << target) & promotion_rank)
+            {
+                // captures mode only wants the queen, under-promotions are quiet moves
+                int first_promotion = type == GEN_QUIETS ? ROOK : QUEEN;
+                int last_promotion = type == GEN_CAPTURES ? QUEEN : KNIGHT;
+                for (int promotion_piece = first_promotion; promotion_piece >= last_promotion; promotion_piece--)
+                {
+                    moves.push_back(legal_move | promotion_piece << 18);
+                }
+            }
+            else
+            {
+                moves.push_back(legal_move);
+            }
+            pawn_moves &= pawn_moves - 1;
         }
         bitboard &= bitboard - 1;
     }
@@ -578,11 +1125,15 @@ vector<int> Board::generate_legal_moves(Color color)
     while (bitboard)
     {
         int start = __builtin_ctzll(bitboard);
-        u64 attacks = AttackTables::knight_attacks((Square)start) & ~blockers[color] & checkmask & pin_masks[start];
+        u64 attacks = AttackTables::knight_attacks((Square)start) & targets & checkmask & pin_masks[start];
+        if (type == GEN_QUIET_CHECKS)
+        {
+            attacks &= quiet_check_targets(color, KNIGHT, (Square)start);
+        }
         while (attacks)
         {
             int target = __builtin_ctzll(attacks);
-            legal_moves.push_back(KNIGHT << 12 | target << 6 | start);
+            moves.push_back(squares[target] << 15 | KNIGHT << 12 | target << 6 | start);
             attacks &= attacks - 1;
         }
         bitboard &= bitboard - 1;
@@ -593,11 +1144,15 @@ vector<int> Board::generate_legal_moves(Color color)
     while (bitboard)
     {
         int start = __builtin_ctzll(bitboard);
-        u64 attacks = AttackTables::bishop_attacks((Square)start, blockers_all) & ~blockers[color] & checkmask & pin_masks[start];
+        u64 attacks = AttackTables::bishop_attacks((Square)start, blockers_all) & targets & checkmask & pin_masks[start];
+        if (type == GEN_QUIET_CHECKS)
+        {
+            attacks &= quiet_check_targets(color, BISHOP, (Square)start);
+        }
         while (attacks)
         {
             int target = __builtin_ctzll(attacks);
-            legal_moves.push_back(BISHOP << 12 | target << 6 | start);
+            moves.push_back(squares[target] << 15 | BISHOP << 12 | target << 6 | start);
             attacks &= attacks - 1;
         }
         bitboard &= bitboard - 1;
@@ -608,11 +1163,15 @@ vector<int> Board::generate_legal_moves(Color color)
     while (bitboard)
     {
         int start = __builtin_ctzll(bitboard);
-        u64 attacks = AttackTables::rook_attacks((Square)start, blockers_all) & ~blockers[color] & checkmask & pin_masks[start];
+        u64 attacks = AttackTables::rook_attacks((Square)start, blockers_all) & targets & checkmask & pin_masks[start];
+        if (type == GEN_QUIET_CHECKS)
+        {
+            attacks &= quiet_check_targets(color, ROOK, (Square)start);
+        }
         while (attacks)
         {
             int target = __builtin_ctzll(attacks);
-            legal_moves.push_back(ROOK << 12 | target << 6 | start);
+            moves.push_back(squares[target] << 15 | ROOK << 12 | target << 6 | start);
             attacks &= attacks - 1;
         }
         bitboard &= bitboard - 1;
@@ -623,33 +1182,449 @@ vector<int> Board::generate_legal_moves(Color color)
     while (bitboard)
     {
         int start = __builtin_ctzll(bitboard);
-        u64 attacks = AttackTables::queen_attacks((Square)start, blockers_all) & ~blockers[color] & checkmask & pin_masks[start];
+        u64 attacks = AttackTables::queen_attacks((Square)start, blockers_all) & targets & checkmask & pin_masks[start];
+        if (type == GEN_QUIET_CHECKS)
+        {
+            attacks &= quiet_check_targets(color, QUEEN, (Square)start);
+        }
         while (attacks)
         {
             int target = __builtin_ctzll(attacks);
-            legal_moves.push_back(QUEEN << 12 | target << 6 | start);
+            moves.push_back(squares[target] << 15 | QUEEN << 12 | target << 6 | start);
             attacks &= attacks - 1;
         }
         bitboard &= bitboard - 1;
     }
 
-    return legal_moves;
+    return moves;
 }
 
-bool Board::is_legal_move(Square start, Square target, Color turn)
+/*
+ * Legal moves for the side to move while it is in check, split by GenType
+ * the same way as generate_moves. Instead of running every piece through the
+ * checkmask it only looks at the few squares that matter: the king's
+ * neighbours, the checker's square and the squares between it and the king.
+ * Pinned pieces are skipped outright, a pinned piece can never block or
+ * capture a checker since its pin line and the check line only meet at the king.
+ * In double check only king moves are generated.
+ */
+vector<int> Board::generate_evasions(Color color, GenType type)
 {
-    vector<int> legal_moves = generate_legal_moves(turn);
+    vector<int> moves;
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    Square king_square = (Square)__builtin_ctzll(pieces[color][KING]);
 
-    for (int move : legal_moves)
+    // king steps, tested with the king lifted off the board so sliders see through it
+    u64 king_targets = type == GEN_CAPTURES ? blockers[!color] : type == GEN_QUIETS ? ~blockers_all : ~blockers[color];
+    u64 attacks = AttackTables::king_attacks(king_square) & king_targets;
+    while (attacks)
     {
-        int from = move & 0x3F;      // bits 0-5
-        int to = (move >> 6) & 0x3F; // bits 6-11
-        if (from == static_cast<int>(start) && to == static_cast<int>(target))
+        int target = __builtin_ctzll(attacks);
+        if (!(attackers_to((Square)target, blockers_all ^ (1ULL << king_square)) & blockers[!color]))
+        {
+            moves.push_back(squares[target] << 15 | KING << 12 | target << 6 | king_square);
+        }
+        attacks &= attacks - 1;
+    }
+    if (checkers & (checkers - 1))
+    {
+        return moves;
+    }
+
+    Square checker_square = (Square)__builtin_ctzll(checkers);
+    u64 movable = blockers[color] & ~pieces[color][KING] & ~king_blockers[color];
+    u64 promotion_rank = 0xffULL | (0xffULL << 56);
+
+    // capture the checker (under-promoting captures count as quiets, like in generate_moves)
+    if (type != GEN_QUIETS || (checkers & promotion_rank))
+    {
+        u64 capturers = attackers_to(checker_square, blockers_all) & movable;
+        while (capturers)
+        {
+            int start = __builtin_ctzll(capturers);
+            int move = squares[checker_square] << 15 | squares[start] << 12 | checker_square << 6 | start;
+            if (squares[start] == PAWN)
+            {
+                add_pawn_moves(moves, move, type);
+            }
+            else if (type != GEN_QUIETS)
+            {
+                moves.push_back(move);
+            }
+            capturers &= capturers - 1;
+        }
+    }
+
+    // a checking pawn that just double pushed can also be taken en passant
+    int forward = color == WHITE ? -8 : 8;
+    if (type != GEN_QUIETS && enpassant_square && (checkers & pieces[!color][PAWN]) &&
+        enpassant_square == 1ULL << (checker_square + forward))
+    {
+        Square target = (Square)(checker_square + forward);
+        u64 capturers = AttackTables::pawn_attacks((Color)!color, target) & pieces[color][PAWN] & movable;
+        while (capturers)
+        {
+            int start = __builtin_ctzll(capturers);
+            // both pawns leave their squares, which can still uncover a slider on the king
+            u64 occupancy_after = (blockers_all ^ (1ULL << start) ^ checkers) | (1ULL << target);
+            if (!(attackers_to(king_square, occupancy_after) & blockers[!color] & ~checkers))
+            {
+                moves.push_back(2 << 21 | PAWN << 12 | target << 6 | start);
+            }
+            capturers &= capturers - 1;
+        }
+    }
+
+    // interpose on the squares between a sliding checker and the king
+    u64 block_squares = AttackTables::between(king_square, checker_square);
+    if (type == GEN_CAPTURES)
+    {
+        block_squares &= promotion_rank; // only queen promotions by pushing
+    }
+    while (block_squares)
+    {
+        int target = __builtin_ctzll(block_squares);
+        if (type != GEN_CAPTURES)
+        {
+            u64 interposers = ((AttackTables::knight_attacks((Square)target) & pieces[color][KNIGHT]) |
+                               (AttackTables::bishop_attacks((Square)target, blockers_all) & (pieces[color][BISHOP] | pieces[color][QUEEN])) |
+                               (AttackTables::rook_attacks((Square)target, blockers_all) & (pieces[color][ROOK] | pieces[color][QUEEN]))) &
+                              movable;
+            while (interposers)
+            {
+                int start = __builtin_ctzll(interposers);
+                moves.push_back(squares[start] << 12 | target << 6 | start);
+                interposers &= interposers - 1;
+            }
+        }
+
+        // the square a pawn would push from; off the board when the block square is on its own back rank
+        int start = target - forward;
+        u64 behind = start >= 0 && start < 64 ? 1ULL << start : 0;
+        if (pieces[color][PAWN] & movable & behind)
+        {
+            add_pawn_moves(moves, PAWN << 12 | target << 6 | start, type);
+        }
+        else if (behind && !(blockers_all & behind))
+        {
+            // double push from the starting rank through an empty square
+            u64 double_push_rank = color == WHITE ? 0xffULL << 32 : 0xffULL << 24;
+            start = target - 2 * forward;
+            if (type != GEN_CAPTURES && ((1ULL << target) & double_push_rank) && (pieces[color][PAWN] & movable & (1ULL << start)))
+            {
+                moves.push_back(1 << 21 | PAWN << 12 | target << 6 | start);
+            }
+        }
+        block_squares &= block_squares - 1;
+    }
+
+    return moves;
+}
+
+// adds a pawn move, expanded into the promotions this GenType wants when it reaches the last rank
+void Board::add_pawn_moves(vector<int> &moves, int move, GenType type)
+{
+    int target = (move >> 6) & 0x3f;
+    if (target >= 8 && target < 56)
+    {
+        if (type != GEN_CAPTURES || ((move >> 15) & 0b111))
+        {
+            moves.push_back(move);
+        }
+        return;
+    }
+    int first_promotion = type == GEN_QUIETS ? ROOK : QUEEN;
+    int last_promotion = type == GEN_CAPTURES ? QUEEN : KNIGHT;
+    for (int promotion_piece = first_promotion; promotion_piece >= last_promotion; promotion_piece--)
+    {
+        moves.push_back(move | promotion_piece << 18);
+    }
+}
+
+/*
+ * Target squares on which a piece gives check in GEN_QUIET_CHECKS mode: the
+ * cached check squares for its type, plus every square off the line to the
+ * enemy king when the piece is uncovering one of our sliders.
+ */
+u64 Board::quiet_check_targets(Color color, PieceType type, Square start)
+{
+    Square enemy_king_square = (Square)__builtin_ctzll(pieces[!color][KING]);
+    u64 targets = check_squares[type];
+    if (king_blockers[!color] & blockers[color] & (1ULL << start))
+    {
+        targets |= ~AttackTables::line(enemy_king_square, start);
+    }
+    return targets;
+}
+
+/*
+ * Checks that a move taken from somewhere other than this position's move
+ * list (the hash table, killer slots) could be generated here: the encoded
+ * piece is on the start square, the target and capture match the board, and
+ * the move follows the piece's movement rules. Whether it leaves the king in
+ * check is left to is_legal, except for castling which is checked fully.
+ */
+bool Board::is_pseudo_legal(int move)
+{
+    Color color = side_to_move;
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    PieceType pt = (PieceType)((move >> 12) & 0b111);
+    int captured_piece = (move >> 15) & 0b111;
+    int promoted_piece = (move >> 18) & 0b111;
+    int special_moves_flag = (move >> 21) & 0b111;
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    u64 target_bb = 1ULL << target;
+
+    if (!move || pt == NO_PIECE || pt > KING || !(pieces[color][pt] & (1ULL << start)) || (blockers[color] & target_bb))
+    {
+        return false;
+    }
+    // the capture encoded in the move has to be the piece on the target (0 for an empty square)
+    if (captured_piece != ((blockers[!color] & target_bb) ? squares[target] : NO_PIECE))
+    {
+        return false;
+    }
+
+    if (special_moves_flag == 3 || special_moves_flag == 4)
+    {
+        CastleSide side = special_moves_flag == 3 ? KINGSIDE : QUEENSIDE;
+        if (pt != KING || promoted_piece || target_bb != castle_square[color][side] ||
+            !(castling_rights & castle_rights_for[color][side]) || (castle_masks[color][side] & blockers_all) || checkers)
+        {
+            return false;
+        }
+        if (squares_attacked(castle_safe_masks[color][side], (Color)!color))
+        {
+            return false;
+        }
+        return true;
+    }
+
+    if (pt == PAWN)
+    {
+        u64 promotion_rank = 0xffULL | (0xffULL << 56);
+        int forward = color == WHITE ? -8 : 8;
+        bool promotes = promoted_piece >= KNIGHT && promoted_piece <= QUEEN;
+        if (((target_bb & promotion_rank) != 0) != promotes || (promoted_piece != NO_PIECE && !promotes))
+        {
+            return false;
+        }
+
+        if (special_moves_flag == 2)
+        {
+            return target_bb == enpassant_square && (AttackTables::pawn_attacks(color, start) & target_bb);
+        }
+        if (special_moves_flag == 1)
+        {
+            u64 start_rank = color == WHITE ? 0xffULL << 48 : 0xffULL << 8;
+            return ((1ULL << start) & start_rank) && target == start + 2 * forward &&
+                   !(blockers_all & ((1ULL << (start + forward)) | target_bb));
+        }
+        if (special_moves_flag)
+        {
+            return false;
+        }
+        if (captured_piece)
+        {
+            return (AttackTables::pawn_attacks(color, start) & target_bb) != 0;
+        }
+        return target == start + forward && !(blockers_all & target_bb);
+    }
+
+    if (special_moves_flag || promoted_piece)
+    {
+        return false;
+    }
+
+    switch (pt)
+    {
+    case KNIGHT:
+        return (AttackTables::knight_attacks(start) & target_bb) != 0;
+    case BISHOP:
+        return (AttackTables::bishop_attacks(start, blockers_all) & target_bb) != 0;
+    case ROOK:
+        return (AttackTables::rook_attacks(start, blockers_all) & target_bb) != 0;
+    case QUEEN:
+        return (AttackTables::queen_attacks(start, blockers_all) & target_bb) != 0;
+    case KING:
+        return (AttackTables::king_attacks(start) & target_bb) != 0;
+    default:
+        return false;
+    }
+}
+
+// whether any of the squares is attacked by color
+bool Board::squares_attacked(u64 squares_bb, Color color)
+{
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    while (squares_bb)
+    {
+        if (attackers_to((Square)__builtin_ctzll(squares_bb), blockers_all) & blockers[color])
+        {
             return true;
+        }
+        squares_bb &= squares_bb - 1;
+    }
+    return false;
+}
+
+/*
+ * Whether a pseudo-legal move leaves the mover's king safe, without playing
+ * it: king moves test the target square, other moves must resolve any check
+ * and pinned pieces must stay on the line through their king.
+ */
+bool Board::is_legal(int move)
+{
+    Color color = side_to_move;
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    PieceType pt = (PieceType)((move >> 12) & 0b111);
+    int special_moves_flag = (move >> 21) & 0b111;
+    Square king_square = (Square)__builtin_ctzll(pieces[color][KING]);
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+
+    if (special_moves_flag == 2)
+    {
+        // both pawns leave their squares, so test the king directly against the new occupancy
+        u64 captured_bb = 1ULL << (color == WHITE ? target + 8 : target - 8);
+        u64 occupancy_after = (blockers_all ^ (1ULL << start) ^ captured_bb) | (1ULL << target);
+        return !(attackers_to(king_square, occupancy_after) & blockers[!color] & ~captured_bb);
+    }
+
+    if (pt == KING)
+    {
+        // castling was fully checked by is_pseudo_legal
+        return special_moves_flag == 3 || special_moves_flag == 4 ||
+               !(attackers_to(target, blockers_all ^ (1ULL << start)) & blockers[!color]);
+    }
+
+    if (checkers)
+    {
+        if (checkers & (checkers - 1))
+        {
+            return false; // double check, only the king can move
+        }
+        if (!((AttackTables::between(king_square, (Square)__builtin_ctzll(checkers)) | checkers) & (1ULL << target)))
+        {
+            return false;
+        }
+    }
+
+    return !(king_blockers[color] & (1ULL << start)) || (AttackTables::line(king_square, start) & (1ULL << target));
+}
+
+/*
+ * Whether a pseudo-legal move gives check, without playing it. Direct checks
+ * come from the cached check squares, discovered checks from our pieces in
+ * king_blockers of the enemy king. Promotions, en passant and castling change
+ * more than one square, so they look at the occupancy after the move.
+ */
+bool Board::gives_check(int move)
+{
+    Color color = side_to_move;
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    PieceType pt = (PieceType)((move >> 12) & 0b111);
+    PieceType promoted_piece = (PieceType)((move >> 18) & 0b111);
+    int special_moves_flag = (move >> 21) & 0b111;
+    Square enemy_king_square = (Square)__builtin_ctzll(pieces[!color][KING]);
+    u64 enemy_king = pieces[!color][KING];
+
+    // direct check (a promoting pawn is handled below)
+    if (!promoted_piece && (check_squares[pt] & (1ULL << target)))
+    {
+        return true;
+    }
+
+    // discovered check, unless the piece stays on the line to the king
+    if ((king_blockers[!color] & blockers[color] & (1ULL << start)) &&
+        !(AttackTables::line(enemy_king_square, start) & (1ULL << target)))
+    {
+        return true;
+    }
+
+    u64 blockers_all = blockers[WHITE] | blockers[BLACK];
+    if (promoted_piece)
+    {
+        // the pawn leaving its square can open the promotion piece's line to the king
+        u64 occupancy = blockers_all ^ (1ULL << start);
+        switch (promoted_piece)
+        {
+        case KNIGHT:
+            return AttackTables::knight_attacks(target) & enemy_king;
+        case BISHOP:
+            return AttackTables::bishop_attacks(target, occupancy) & enemy_king;
+        case ROOK:
+            return AttackTables::rook_attacks(target, occupancy) & enemy_king;
+        default:
+            return AttackTables::queen_attacks(target, occupancy) & enemy_king;
+        }
+    }
+    if (special_moves_flag == 2)
+    {
+        // removing the captured pawn can discover a slider on the enemy king
+        u64 captured_bb = 1ULL << (color == WHITE ? target + 8 : target - 8);
+        u64 occupancy = (blockers_all ^ (1ULL << start) ^ captured_bb) | (1ULL << target);
+        return (AttackTables::rook_attacks(enemy_king_square, occupancy) & (pieces[color][ROOK] | pieces[color][QUEEN])) |
+               (AttackTables::bishop_attacks(enemy_king_square, occupancy) & (pieces[color][BISHOP] | pieces[color][QUEEN]));
+    }
+    if (special_moves_flag == 3 || special_moves_flag == 4)
+    {
+        // the castling rook gives the check, with the king already off its start square
+        Square rook_start = (Square)(special_moves_flag == 3 ? target + 1 : target - 2);
+        Square rook_target = (Square)(special_moves_flag == 3 ? target - 1 : target + 1);
+        u64 occupancy = (blockers_all ^ (1ULL << start) ^ (1ULL << rook_start)) | (1ULL << target) | (1ULL << rook_target);
+        return AttackTables::rook_attacks(rook_target, occupancy) & enemy_king;
     }
     return false;
 }
 
+/*
+ * Encodes a move from its squares the way generate_legal_moves would, e.g.
+ * for user input. The result still has to pass is_pseudo_legal/is_legal.
+ */
+int Board::build_move(Square start, Square target, PieceType promotion)
+{
+    Color color = side_to_move;
+    int pt = squares[start];
+    int captured_piece = (blockers[!color] & (1ULL << target)) ? squares[target] : NO_PIECE;
+    int special_moves_flag = 0;
+    int promoted_piece = 0;
+
+    if (pt == PAWN)
+    {
+        if (abs(target - start) == 16)
+        {
+            special_moves_flag = 1;
+        }
+        else if ((1ULL << target) == enpassant_square && abs(target - start) != 8)
+        {
+            special_moves_flag = 2;
+        }
+        if (target < 8 || target >= 56)
+        {
+            promoted_piece = promotion;
+        }
+    }
+    else if (pt == KING && abs(target - start) == 2)
+    {
+        special_moves_flag = target > start ? 3 : 4;
+    }
+
+    return special_moves_flag << 21 | promoted_piece << 18 | captured_piece << 15 | pt << 12 | target << 6 | start;
+}
+
+bool Board::is_legal_move(Square start, Square target, Color turn)
+{
+    if (turn != side_to_move || !(blockers[turn] & (1ULL << start)))
+    {
+        return false;
+    }
+    int move = build_move(start, target);
+    return is_pseudo_legal(move) && is_legal(move);
+}
+
 u64 Board::get_attacks(Color color)
 {
     u64 attacks = 0, bitboard;
@@ -746,6 +1721,193 @@ bool Board::is_checkmate(Color turn)
     return generate_legal_moves(turn).size() == 0 && (get_attacks(turn == WHITE ? BLACK : WHITE) & pieces[turn][KING]);
 }
 
+bool Board::in_check()
+{
+    return checkers != 0;
+}
+
+// pieces of both colors attacking a square, with sliders blocked by occupancy
+u64 Board::attackers_to(Square square, u64 occupancy)
+{
+    return (AttackTables::pawn_attacks(BLACK, square) & pieces[WHITE][PAWN]) |
+           (AttackTables::pawn_attacks(WHITE, square) & pieces[BLACK][PAWN]) |
+           (AttackTables::knight_attacks(square) & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT])) |
+           (AttackTables::king_attacks(square) & (pieces[WHITE][KING] | pieces[BLACK][KING])) |
+           (AttackTables::bishop_attacks(square, occupancy) & (pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN])) |
+           (AttackTables::rook_attacks(square, occupancy) & (pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN]));
+}
+
+/*
+ * Static exchange evaluation: the material balance of the capture sequence a
+ * move starts on its target square, with both sides always recapturing with
+ * their least valuable attacker and either side free to stop. Sliders hidden
+ * behind a piece that recaptures are picked up as it leaves (x-rays). Nothing
+ * is played on the board and pins are ignored.
+ */
+int Board::see(int move)
+{
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    int special_moves_flag = (move >> 21) & 0b111;
+    if (special_moves_flag == 3 || special_moves_flag == 4)
+    {
+        return 0;
+    }
+
+    int promoted_piece = (move >> 18) & 0b111;
+    int on_square = promoted_piece ? promoted_piece : squares[start]; // piece left on the target square
+    u64 occupancy = (blockers[WHITE] | blockers[BLACK]) ^ (1ULL << start);
+    int gain[32], d = 0;
+
+    gain[0] = PIECE_VALUES[squares[target]];
+    if (special_moves_flag == 2)
+    {
+        gain[0] = PIECE_VALUES[PAWN];
+        occupancy ^= 1ULL << (side_to_move == WHITE ? target + 8 : target - 8);
+    }
+    if (promoted_piece)
+    {
+        gain[0] += PIECE_VALUES[promoted_piece] - PIECE_VALUES[PAWN];
+    }
+
+    u64 diagonal_sliders = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    u64 straight_sliders = pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    u64 attackers = attackers_to(target, occupancy) & occupancy;
+    Color color = side_to_move;
+
+    while (true)
+    {
+        color = color == WHITE ? BLACK : WHITE;
+        u64 color_attackers = attackers & blockers[color];
+        if (!color_attackers)
+        {
+            break;
+        }
+
+        int attacker = PAWN;
+        while (!(color_attackers & pieces[color][attacker]))
+        {
+            attacker++;
+        }
+        // the king can only recapture if nothing would take it back
+        if (attacker == KING && (attackers & blockers[!color]))
+        {
+            break;
+        }
+
+        d++;
+        gain[d] = PIECE_VALUES[on_square] - gain[d - 1];
+        on_square = attacker;
+
+        occupancy ^= 1ULL << __builtin_ctzll(color_attackers & pieces[color][attacker]);
+        if (attacker == PAWN || attacker == BISHOP || attacker == QUEEN)
+        {
+            attackers |= AttackTables::bishop_attacks(target, occupancy) & diagonal_sliders;
+        }
+        if (attacker == ROOK || attacker == QUEEN)
+        {
+            attackers |= AttackTables::rook_attacks(target, occupancy) & straight_sliders;
+        }
+        attackers &= occupancy;
+    }
+
+    // negamax the swap list back to the first capture
+    while (d)
+    {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+/*
+ * True if see(move) >= threshold. Stops as soon as the outcome is settled,
+ * which is usually after one or two recaptures.
+ */
+bool Board::see_ge(int move, int threshold)
+{
+    Square start = (Square)(move & 0x3f);
+    Square target = (Square)((move >> 6) & 0x3f);
+    int special_moves_flag = (move >> 21) & 0b111;
+    if (special_moves_flag == 3 || special_moves_flag == 4)
+    {
+        return 0 >= threshold;
+    }
+
+    int promoted_piece = (move >> 18) & 0b111;
+    u64 occupancy = (blockers[WHITE] | blockers[BLACK]) ^ (1ULL << start);
+
+    // balance after the first capture, from our point of view, minus the threshold
+    int swap = PIECE_VALUES[squares[target]] - threshold;
+    if (special_moves_flag == 2)
+    {
+        swap = PIECE_VALUES[PAWN] - threshold;
+        occupancy ^= 1ULL << (side_to_move == WHITE ? target + 8 : target - 8);
+    }
+    if (promoted_piece)
+    {
+        swap += PIECE_VALUES[promoted_piece] - PIECE_VALUES[PAWN];
+    }
+    if (swap < 0)
+    {
+        return false;
+    }
+
+    // even losing the piece we moved, we're still at or above the threshold
+    swap = PIECE_VALUES[promoted_piece ? promoted_piece : squares[start]] - swap;
+    if (swap <= 0)
+    {
+        return true;
+    }
+
+    u64 diagonal_sliders = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    u64 straight_sliders = pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    u64 attackers = attackers_to(target, occupancy) & occupancy;
+    Color color = side_to_move;
+    int result = 1;
+
+    while (true)
+    {
+        color = color == WHITE ? BLACK : WHITE;
+        attackers &= occupancy;
+        u64 color_attackers = attackers & blockers[color];
+        if (!color_attackers)
+        {
+            break;
+        }
+        result ^= 1;
+
+        int attacker = PAWN;
+        while (!(color_attackers & pieces[color][attacker]))
+        {
+            attacker++;
+        }
+        if (attacker == KING)
+        {
+            // capturing with the king only works if the other side has run out of attackers
+            return (attackers & blockers[!color]) ? result ^ 1 : result;
+        }
+
+        swap = PIECE_VALUES[attacker] - swap;
+        if (swap < result)
+        {
+            break;
+        }
+
+        occupancy ^= 1ULL << __builtin_ctzll(color_attackers & pieces[color][attacker]);
+        if (attacker == PAWN || attacker == BISHOP || attacker == QUEEN)
+        {
+            attackers |= AttackTables::bishop_attacks(target, occupancy) & diagonal_sliders;
+        }
+        if (attacker == ROOK || attacker == QUEEN)
+        {
+            attackers |= AttackTables::rook_attacks(target, occupancy) & straight_sliders;
+        }
+    }
+
+    return result;
+}
+
 bool Board::is_stalemate(Color turn)
 {
     return generate_legal_moves(turn).size() == 0 && !(get_attacks(turn == WHITE ? BLACK : WHITE) & pieces[turn][KING]);
@@ -794,7 +1956,7 @@ long Board::perft(int depth, int max_depth)
             }
 
             // Measure make_move
-            make_move((Square)start, (Square)target, side_to_move, legal_moves);
+            make_move(move);
 
             current_move_nodes = perft(depth - 1, max_depth);
             nodes += current_move_nodes;
@@ -832,4 +1994,39 @@ string Board::coordinates(int square)
     char rank = '0' + rankValue;
 
     return string(1, file) + string(1, rank); // e.g., "e4"
-}
\ No newline at end of file
+}
+
+// long algebraic notation, e.g. "e2e4" or "e7e8q"
+string Board::move_to_string(int move)
+{
+    string result = coordinates(move & 0x3f) + coordinates((move >> 6) & 0x3f);
+    int promoted_piece = (move >> 18) & 0b111;
+    if (promoted_piece)
+    {
+        result += piece_types[BLACK][promoted_piece];
+    }
+    return result;
+}
+
+// parses a move in the same notation (e.g. "e2e4", "e7e8q"), 0 if it isn't legal here
+int Board::parse_move(string text)
+{
+    if (text.size() < 4 || text[0] < 'a' || text[0] > 'h' || text[2] < 'a' || text[2] > 'h' ||
+        text[1] < '1' || text[1] > '8' || text[3] < '1' || text[3] > '8')
+    {
+        return 0;
+    }
+    Square start = (Square)(8 * (8 - (text[1] - '0')) + (text[0] - 'a'));
+    Square target = (Square)(8 * (8 - (text[3] - '0')) + (text[2] - 'a'));
+    PieceType promotion = QUEEN;
+    if (text.size() > 4)
+    {
+        promotion = (PieceType)type_of(toupper(text[4]));
+    }
+    if (!(blockers[side_to_move] & (1ULL << start)))
+    {
+        return 0;
+    }
+    int move = build_move(start, target, promotion);
+    return is_pseudo_legal(move) && is_legal(move) ? move : 0;
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstdlib>
+#include "../include/endgames.hpp"
+#include "../include/kpk_bitbase.hpp"
+
+static int file_of(int square)
+{
+    return square & 7;
+}
+
+static int rank_of(int square)
+{
+    return 7 - square / 8;
+}
+
+static int distance(int a, int b)
+{
+    return std::max(std::abs(file_of(a) - file_of(b)), std::abs(rank_of(a) - rank_of(b)));
+}
+
+static int edge_distance(int square)
+{
+    return std::min({file_of(square), 7 - file_of(square), rank_of(square), 7 - rank_of(square)});
+}
+
+// bonuses for driving the weak king to the edge and bringing the strong king next to it
+static int push_to_edge(int square)
+{
+    return 90 - 30 * edge_distance(square);
+}
+
+static int push_close(int a, int b)
+{
+    return 140 - 20 * distance(a, b);
+}
+
+static Square king_square(Board &board, Color color)
+{
+    return (Square)__builtin_ctzll(board.get_pieces(color, KING));
+}
+
+static Color other(Color color)
+{
+    return color == WHITE ? BLACK : WHITE;
+}
+
+int Endgames::draw(Board & /*board*/, Color /*strong*/)
+{
+    return 0;
+}
+
+int Endgames::kxk(Board &board, Color strong)
+{
+    // nothing to do for a stalemate, the search will find it
+    Square strong_king = king_square(board, strong), weak_king = king_square(board, other(strong));
+    int material = 0;
+    for (int type = PAWN; type <= QUEEN; type++)
+    {
+        material += PIECE_VALUES[type] * board.material_count(strong, (PieceType)type);
+    }
+    return KNOWN_WIN + material + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+}
+
+/*
+ * Mate is only possible in a corner of the bishop's color, so the weak king
+ * is driven towards the nearer of those two rather than to any edge.
+ */
+int Endgames::kbnk(Board &board, Color strong)
+{
+    Square strong_king = king_square(board, strong), weak_king = king_square(board, other(strong));
+    int bishop = __builtin_ctzll(board.get_pieces(strong, BISHOP));
+    bool dark = (file_of(bishop) + rank_of(bishop)) % 2 == 0; // a1 is dark
+    int corner_distance = dark ? std::min(distance(weak_king, a1), distance(weak_king, h8))
+                               : std::min(distance(weak_king, a8), distance(weak_king, h1));
+    return KNOWN_WIN + PIECE_VALUES[KNIGHT] + PIECE_VALUES[BISHOP] + 60 * (7 - corner_distance) + push_close(strong_king, weak_king);
+}
+
+int Endgames::kpk(Board &board, Color strong)
+{
+    Square strong_king = king_square(board, strong), weak_king = king_square(board, other(strong));
+    int pawn = __builtin_ctzll(board.get_pieces(strong, PAWN));
+    if (!KPKBitbase::probe(strong, strong_king, (Square)pawn, weak_king, board.get_side()))
+    {
+        return 0;
+    }
+    int relative_rank = strong == WHITE ? rank_of(pawn) : 7 - rank_of(pawn);
+    return KNOWN_WIN + PIECE_VALUES[PAWN] + 20 * relative_rank;
+}
+
+// usually won but slowly, so scored as a big advantage rather than a known win
+int Endgames::kqkr(Board &board, Color strong)
+{
+    Square strong_king = king_square(board, strong), weak_king = king_square(board, other(strong));
+    return PIECE_VALUES[QUEEN] - PIECE_VALUES[ROOK] + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+}
+
+int Endgames::opposite_bishops(Board &board)
+{
+    int white_bishop = __builtin_ctzll(board.get_pieces(WHITE, BISHOP));
+    int black_bishop = __builtin_ctzll(board.get_pieces(BLACK, BISHOP));
+    if ((file_of(white_bishop) + rank_of(white_bishop)) % 2 == (file_of(black_bishop) + rank_of(black_bishop)) % 2)
+    {
+        return 64;
+    }
+    // the closer the pawn counts, the more likely a blockade holds
+    int pawn_difference = std::abs(board.material_count(WHITE, PAWN) - board.material_count(BLACK, PAWN));
+    return pawn_difference <= 1 ? 16 : 32;
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdlib>
+#include "../include/evaluation.hpp"
+
+Evaluator::Evaluator() : cache(CACHE_SIZE)
+{
+}
+
+/*
+ * Transpositions and re-searches evaluate the same position again and again,
+ * so the result is kept in a small direct-mapped cache keyed by the zobrist
+ * hash. A new entry always replaces the old one. Lazy estimates are not
+ * cached, another probe may come with a window they don't satisfy.
+ */
+int Evaluator::evaluate(Board &board, int alpha, int beta)
+{
+    u64 key = board.get_hash();
+    u64 &entry = cache[key & (CACHE_SIZE - 1)];
+    cache_probes++;
+    if (((entry ^ key) >> 16) == 0)
+    {
+        cache_hits++;
+        return (int16_t)(entry & 0xffff);
+    }
+
+    bool lazy = false;
+    int score = compute(board, alpha, beta, lazy);
+    if (lazy)
+    {
+        lazy_exits++;
+        if (verify_lazy)
+        {
+            int full = compute(board, -NO_BOUND, NO_BOUND, lazy);
+            lazy_error += std::abs(full - score);
+            lazy_wrong_side += score <= alpha ? full > alpha : full < beta;
+        }
+        return score;
+    }
+    entry = (key & ~0xffffULL) | (uint16_t)score;
+    return score;
+}
+
+// the cached scores are only valid for the network they were computed with
+void Evaluator::clear_cache()
+{
+    std::fill(cache.begin(), cache.end(), 0);
+}
+
+void Evaluator::reset_stats()
+{
+    cache_probes = 0;
+    cache_hits = 0;
+    lazy_exits = 0;
+    lazy_wrong_side = 0;
+    lazy_error = 0;
+    pawn_table.reset_stats();
+}
+
+/*
+ * Material and piece-square tables, read straight off the board's incrementally
+ * updated score pair, plus the cached pawn structure and material imbalance
+ * terms. The mobility, king safety and threat terms come on top of those.
+ *
+ * The total is blended by game phase: 24 with every minor, rook and queen on
+ * the board (pure middlegame) down to 0 (pure endgame). Known endgames skip
+ * all of that for their own routine, and with a network loaded everything
+ * else is the network's call.
+ *
+ * When material and piece-square tables alone put the score more than
+ * LAZY_MARGIN outside (alpha, beta), the other terms are very unlikely to
+ * bring it back and that estimate is returned as it is (lazy is set).
+ */
+int Evaluator::compute(Board &board, int alpha, int beta, bool &lazy)
+{
+    MaterialEntry *material = material_table.probe(board);
+    if (material->evaluation)
+    {
+        int score = material->evaluation(board, material->strong);
+        return board.get_side() == material->strong ? score : -score;
+    }
+    if (board.nnue_enabled())
+    {
+        return NNUE::evaluate(board.get_accumulator(), board.get_side());
+    }
+
+    Score base = board.get_psq() + material->imbalance;
+    if (!material->scaling)
+    {
+        int estimate = taper(base, material->phase);
+        estimate = board.get_side() == WHITE ? estimate : -estimate;
+        if (estimate + LAZY_MARGIN <= alpha || estimate - LAZY_MARGIN >= beta)
+        {
+            lazy = true;
+            return estimate;
+        }
+    }
+
+    PawnEntry *pawns = pawn_table.probe(board);
+    Score total = base + pawns->score + evaluate_pieces(board, pawns);
+    int score;
+    if (material->scaling)
+    {
+        int eg = eg_value(total) * material->scaling(board) / 64;
+        score = eg + (((mg_value(total) - eg) * material->phase) >> 8);
+    }
+    else
+    {
+        score = taper(total, material->phase);
+    }
+    return board.get_side() == WHITE ? score : -score;
+}
+
+/*
+ * Fills in the attack maps and scores mobility on the way. Pawn attacks come
+ * from the pawn cache. A piece's mobility counts the squares it attacks that
+ * are not blocked by its own pawns or king and not covered by enemy pawns.
+ */
+Score Evaluator::evaluate_pieces(Board &board, PawnEntry *pawns)
+{
+    u64 occupancy = board.get_occupancy(WHITE) | board.get_occupancy(BLACK);
+    for (Color color : {WHITE, BLACK})
+    {
+        Square king = (Square)__builtin_ctzll(board.get_pieces(color, KING));
+        attacks.by_type[color][PAWN] = pawns->attacks[color];
+        attacks.by_type[color][KING] = AttackTables::king_attacks(king);
+        attacks.all[color] = attacks.by_type[color][PAWN] | attacks.by_type[color][KING];
+        attacks.king_zone[color] = attacks.by_type[color][KING] | (1ULL << king);
+        attacks.king_attackers[color] = 0;
+        attacks.king_attack_weight[color] = 0;
+    }
+
+    Score score = 0;
+    for (Color color : {WHITE, BLACK})
+    {
+        Color enemy = color == WHITE ? BLACK : WHITE;
+        u64 mobility_area = ~(board.get_pieces(color, PAWN) | board.get_pieces(color, KING) | pawns->attacks[enemy]);
+        Score side = 0;
+        for (int type = KNIGHT; type <= QUEEN; type++)
+        {
+            attacks.by_type[color][type] = 0;
+            attacks.mobility[color][type] = 0;
+            for (u64 bitboard = board.get_pieces(color, (PieceType)type); bitboard; bitboard &= bitboard - 1)
+            {
+                Square square = (Square)__builtin_ctzll(bitboard);
+                u64 targets = type == KNIGHT   ? AttackTables::knight_attacks(square)
+                              : type == BISHOP ? AttackTables::bishop_attacks(square, occupancy)
+                              : type == ROOK   ? AttackTables::rook_attacks(square, occupancy)
+                                               : AttackTables::queen_attacks(square, occupancy);
+                attacks.by_type[color][type] |= targets;
+                attacks.all[color] |= targets;
+
+                attacks.mobility[color][type] += __builtin_popcountll(targets & mobility_area) - MOBILITY_BASE[type];
+
+                u64 zone_hits = targets & attacks.king_zone[enemy];
+                if (zone_hits)
+                {
+                    attacks.king_attackers[enemy]++;
+                    attacks.king_attack_weight[enemy] += KING_ATTACK_WEIGHTS[type] * __builtin_popcountll(zone_hits);
+                }
+            }
+            side += MOBILITY[type] * attacks.mobility[color][type];
+        }
+        score += color == WHITE ? side : -side;
+    }
+
+    score += evaluate_king_safety(WHITE) - evaluate_king_safety(BLACK);
+    score += evaluate_threats(board);
+    return score;
+}
+
+/*
+ * Penalty for the pieces bearing down on a king. A single attacker is rarely
+ * dangerous, so it takes two before anything counts, and the penalty grows
+ * with the square of the attack weight, mostly in the middlegame.
+ */
+Score Evaluator::evaluate_king_safety(Color color)
+{
+    if (attacks.king_attackers[color] < 2)
+    {
+        return 0;
+    }
+    int weight = attacks.king_attack_weight[color];
+    return make_score(-std::min(weight * weight / 8, 600), -weight);
+}
+
+// positive for white; pieces attacked by cheaper pieces, and pieces attacked without any defender
+Score Evaluator::evaluate_threats(Board &board)
+{
+    Score score = 0;
+    for (Color color : {WHITE, BLACK})
+    {
+        Color enemy = color == WHITE ? BLACK : WHITE;
+        u64 minors = board.get_pieces(enemy, KNIGHT) | board.get_pieces(enemy, BISHOP);
+        u64 rooks = board.get_pieces(enemy, ROOK), queens = board.get_pieces(enemy, QUEEN);
+        u64 pawn_attacks = attacks.by_type[color][PAWN];
+        u64 minor_attacks = attacks.by_type[color][KNIGHT] | attacks.by_type[color][BISHOP];
+
+        attacks.threatened[color] = (minors & pawn_attacks) | (rooks & (pawn_attacks | minor_attacks)) |
+                                    (queens & (pawn_attacks | minor_attacks | attacks.by_type[color][ROOK]));
+        attacks.hanging[color] = (board.get_occupancy(enemy) & ~board.get_pieces(enemy, KING)) & attacks.all[color] & ~attacks.all[enemy];
+
+        Score side = THREAT_BY_LESSER * __builtin_popcountll(attacks.threatened[color]) + HANGING * __builtin_popcountll(attacks.hanging[color]);
+        score += color == WHITE ? side : -side;
+    }
+    return score;
+}
@@ -0,0 +1,164 @@
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "../include/kpk_bitbase.hpp"
+#include "../include/attack_tables.hpp"
+
+u64 KPKBitbase::bits[SIZE / 64];
+
+enum
+{
+    INVALID = 0,
+    UNKNOWN = 1,
+    DRAW = 2,
+    WIN = 4
+};
+
+// pawn squares a7-d7 down to a2-d2 are numbered 0..23
+static int pawn_square(int pawn)
+{
+    return (pawn / 4 + 1) * 8 + pawn % 4;
+}
+
+static int pawn_number(int square)
+{
+    return (square / 8 - 1) * 4 + square % 8;
+}
+
+int KPKBitbase::index(Color side, int white_king, int black_king, int pawn)
+{
+    return side + 2 * black_king + 128 * white_king + 8192 * pawn;
+}
+
+/*
+ * Positions that are decided without looking ahead: illegal ones, pawn
+ * promotes safely, black is stalemated or simply takes the pawn.
+ */
+static int initial_result(Color side, int white_king, int black_king, int pawn)
+{
+    Square wk = (Square)white_king, bk = (Square)black_king, ps = (Square)pawn;
+    u64 white_king_attacks = AttackTables::king_attacks(wk);
+    u64 black_king_attacks = AttackTables::king_attacks(bk);
+    u64 pawn_attacks = AttackTables::pawn_attacks(WHITE, ps);
+
+    if (wk == bk || wk == ps || bk == ps || (white_king_attacks & (1ULL << bk)) ||
+        (side == WHITE && (pawn_attacks & (1ULL << bk))))
+    {
+        return INVALID;
+    }
+    int promotion = pawn - 8;
+    if (side == WHITE && pawn / 8 == 1 && promotion != white_king && promotion != black_king &&
+        (!(black_king_attacks & (1ULL << promotion)) || (white_king_attacks & (1ULL << promotion))))
+    {
+        return WIN;
+    }
+    if (side == BLACK && (!(black_king_attacks & ~(white_king_attacks | pawn_attacks)) ||
+                          (black_king_attacks & (1ULL << ps) & ~white_king_attacks)))
+    {
+        return DRAW;
+    }
+    return UNKNOWN;
+}
+
+/*
+ * Retrograde analysis: keep resolving unknown positions from their
+ * successors until nothing changes. White needs one winning move, black one
+ * drawing move; whatever is still unknown at the end is a draw.
+ */
+void KPKBitbase::build()
+{
+    AttackTables::init();
+
+    std::vector<uint8_t> results(SIZE);
+    for (int pawn = 0; pawn < 24; pawn++)
+    {
+        for (int white_king = 0; white_king < 64; white_king++)
+        {
+            for (int black_king = 0; black_king < 64; black_king++)
+            {
+                for (Color side : {WHITE, BLACK})
+                {
+                    results[index(side, white_king, black_king, pawn)] = initial_result(side, white_king, black_king, pawn_square(pawn));
+                }
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int i = 0; i < SIZE; i++)
+        {
+            if (results[i] != UNKNOWN)
+            {
+                continue;
+            }
+            Color side = (Color)(i & 1);
+            int black_king = (i >> 1) & 63;
+            int white_king = (i >> 7) & 63;
+            int pawn = i >> 13;
+            int square = pawn_square(pawn);
+
+            int successors = INVALID;
+            if (side == WHITE)
+            {
+                u64 moves = AttackTables::king_attacks((Square)white_king) & ~AttackTables::king_attacks((Square)black_king) & ~(1ULL << square);
+                for (; moves; moves &= moves - 1)
+                {
+                    successors |= results[index(BLACK, __builtin_ctzll(moves), black_king, pawn)];
+                }
+                // pushes to the eighth rank were settled by initial_result
+                int push = square - 8;
+                if (square / 8 > 1 && push != white_king && push != black_king)
+                {
+                    successors |= results[index(BLACK, white_king, black_king, pawn_number(push))];
+                    int double_push = push - 8;
+                    if (square / 8 == 6 && double_push != white_king && double_push != black_king)
+                    {
+                        successors |= results[index(BLACK, white_king, black_king, pawn_number(double_push))];
+                    }
+                }
+                results[i] = successors & WIN ? WIN : successors & UNKNOWN ? UNKNOWN : DRAW;
+            }
+            else
+            {
+                u64 moves = AttackTables::king_attacks((Square)black_king) & ~AttackTables::king_attacks((Square)white_king) &
+                            ~AttackTables::pawn_attacks(WHITE, (Square)square) & ~(1ULL << square);
+                for (; moves; moves &= moves - 1)
+                {
+                    successors |= results[index(WHITE, white_king, __builtin_ctzll(moves), pawn)];
+                }
+                results[i] = successors & DRAW ? DRAW : successors & UNKNOWN ? UNKNOWN : WIN;
+            }
+            changed |= results[i] != UNKNOWN;
+        }
+    }
+
+    for (int i = 0; i < SIZE; i++)
+    {
+        if (results[i] == WIN)
+        {
+            bits[i / 64] |= 1ULL << (i % 64);
+        }
+    }
+}
+
+// every Evaluator calls this, possibly several threads at once
+void KPKBitbase::init()
+{
+    static std::once_flag once;
+    std::call_once(once, build);
+}
+
+bool KPKBitbase::probe(Color strong, Square strong_king, Square pawn, Square weak_king, Color side_to_move)
+{
+    int flip = strong == WHITE ? 0 : 56; // mirror ranks so the pawn side plays up the board as white
+    if (((pawn ^ flip) & 7) >= 4)
+    {
+        flip ^= 7; // and files so the pawn is on a-d
+    }
+    Color side = side_to_move == strong ? WHITE : BLACK;
+    int i = index(side, strong_king ^ flip, weak_king ^ flip, pawn_number(pawn ^ flip));
+    return bits[i / 64] >> (i % 64) & 1;
+}
@@ -50,7 +50,7 @@ u64 MagicBitboards::generate_magic_number_candidate()
     return random_uint64() & random_uint64() & random_uint64();
 }
 
-int MagicBitboards::count_one_bits(uint64_t bitBoard)
+int MagicBitboards::count_one_bits(u64 bitBoard)
 {
     int count = 0;
 
@@ -0,0 +1,102 @@
+#include "../include/material.hpp"
+#include "../include/kpk_bitbase.hpp"
+
+MaterialTable::MaterialTable() : entries(1 << SIZE_BITS)
+{
+    KPKBitbase::init();
+}
+
+/*
+ * Picks the specialised evaluation for known endgames, the first matching
+ * case wins. Anything not listed gets the general evaluation.
+ */
+void MaterialTable::analyse(u64 signature, MaterialEntry &entry)
+{
+    auto count = [signature](Color color, PieceType type)
+    { return PSQT::signature_count(signature, color, type); };
+
+    int phase = 0;
+    entry.imbalance = 0;
+    for (Color color : {WHITE, BLACK})
+    {
+        Score imbalance = (count(color, BISHOP) >= 2) * BISHOP_PAIR +
+                          (count(color, PAWN) - 5) * (count(color, KNIGHT) * KNIGHT_PAWN + count(color, ROOK) * ROOK_PAWN);
+        entry.imbalance += color == WHITE ? imbalance : -imbalance;
+        for (int type = KNIGHT; type <= QUEEN; type++)
+        {
+            phase += PSQT::PHASE_WEIGHTS[type] * count(color, (PieceType)type);
+        }
+    }
+    entry.phase = scaled_phase(phase);
+    entry.evaluation = nullptr;
+    entry.scaling = nullptr;
+    entry.strong = WHITE;
+
+    for (Color strong : {WHITE, BLACK})
+    {
+        Color weak = strong == WHITE ? BLACK : WHITE;
+        int pawns = count(strong, PAWN), knights = count(strong, KNIGHT), bishops = count(strong, BISHOP);
+        int majors = count(strong, ROOK) + count(strong, QUEEN);
+        if (count(weak, PAWN) + count(weak, KNIGHT) + count(weak, BISHOP) + count(weak, ROOK) + count(weak, QUEEN))
+        {
+            continue; // the weak side has more than its king
+        }
+        entry.strong = strong;
+        if (majors)
+        {
+            entry.evaluation = Endgames::kxk;
+        }
+        else if (!pawns && knights == 1 && bishops == 1)
+        {
+            entry.evaluation = Endgames::kbnk;
+        }
+        else if (pawns == 1 && !knights && !bishops)
+        {
+            entry.evaluation = Endgames::kpk;
+        }
+        else if (!pawns && (knights + bishops <= 1 || (knights == 2 && !bishops)))
+        {
+            entry.evaluation = Endgames::draw; // KK, KNK, KBK, KNNK
+        }
+        return;
+    }
+
+    for (Color strong : {WHITE, BLACK})
+    {
+        Color weak = strong == WHITE ? BLACK : WHITE;
+        if (signature == PSQT::signature_unit(strong, QUEEN) + PSQT::signature_unit(weak, ROOK))
+        {
+            entry.strong = strong;
+            entry.evaluation = Endgames::kqkr;
+            return;
+        }
+    }
+
+    // a bishop each and nothing but pawns besides, whether they are of opposite colors is up to the board
+    bool only_bishops = true;
+    for (Color color : {WHITE, BLACK})
+    {
+        only_bishops &= count(color, BISHOP) == 1 && !count(color, KNIGHT) && !count(color, ROOK) && !count(color, QUEEN);
+    }
+    if (only_bishops)
+    {
+        entry.scaling = Endgames::opposite_bishops;
+    }
+}
+
+MaterialEntry *MaterialTable::probe(Board &board)
+{
+    u64 key = board.get_material_signature();
+    MaterialEntry &entry = entries[(key * 0x9e3779b97f4a7c15ULL) >> (64 - SIZE_BITS)];
+    if (entry.key != key)
+    {
+        entry.key = key;
+        analyse(key, entry);
+    }
+    return &entry;
+}
+
+void MaterialTable::clear()
+{
+    std::fill(entries.begin(), entries.end(), MaterialEntry());
+}
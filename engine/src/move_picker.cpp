@@ -0,0 +1,213 @@
+#include "../include/move_picker.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+void MoveHistory::clear()
+{
+    memset(butterfly, 0, sizeof(butterfly));
+    memset(killers, 0, sizeof(killers));
+    memset(countermoves, 0, sizeof(countermoves));
+}
+
+// history gravity: the bonus shrinks as the entry approaches MAX_HISTORY, so entries never overflow
+void MoveHistory::update_quiet(Color color, int move, int bonus)
+{
+    int16_t &entry = butterfly[color][move & 0x3f][(move >> 6) & 0x3f];
+    bonus = std::max(-MAX_HISTORY, std::min(MAX_HISTORY, bonus));
+    entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+}
+
+void MoveHistory::update_killer(int ply, int move)
+{
+    if (killers[ply][0] != move)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+}
+
+MovePicker::MovePicker(Board &board, MoveHistory &history, int tt_move, int ply, int rotation)
+    : board(board), history(history), tt_move(tt_move), ply(ply), rotation(rotation)
+{
+    stage = tt_move && board.is_pseudo_legal(tt_move) && board.is_legal(tt_move) ? TT_MOVE : GENERATE_CAPTURES;
+
+    int previous = board.last_move();
+    refutations[0] = history.killers[ply][0];
+    refutations[1] = history.killers[ply][1];
+    refutations[2] = previous ? history.countermoves[(previous >> 12) & 0b111][(previous >> 6) & 0x3f] : 0;
+}
+
+MovePicker::MovePicker(Board &board, MoveHistory &history, bool quiet_checks)
+    : board(board), history(history), stage(QS_GENERATE_CAPTURES), tt_move(0), ply(0), rotation(0), quiet_checks(quiet_checks)
+{
+    refutations[0] = refutations[1] = refutations[2] = 0;
+}
+
+// captures and queen promotions, the moves the captures stage hands out
+bool MovePicker::is_tactical(int move)
+{
+    return ((move >> 15) & 0b111) || ((move >> 21) & 0b111) == 2 || ((move >> 18) & 0b111) == QUEEN;
+}
+
+void MovePicker::score_captures()
+{
+    scores.resize(moves.size());
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        int move = moves[i];
+        int mvv_lva = PIECE_VALUES[(move >> 15) & 0b111] * 8 + PIECE_VALUES[(move >> 18) & 0b111] - ((move >> 12) & 0b111);
+        scores[i] = mvv_lva;
+    }
+}
+
+void MovePicker::score_quiets()
+{
+    Color color = board.get_side();
+    scores.resize(moves.size());
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        scores[i] = history.butterfly[color][moves[i] & 0x3f][(moves[i] >> 6) & 0x3f];
+    }
+}
+
+// swaps the highest scored remaining move to the front and returns it
+int MovePicker::select_best()
+{
+    size_t best = current;
+    for (size_t i = current + 1; i < moves.size(); i++)
+    {
+        if (scores[i] > scores[best])
+        {
+            best = i;
+        }
+    }
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+
+    return moves[current++];
+}
+
+int MovePicker::next_move()
+{
+    int move;
+    switch (stage)
+    {
+    case TT_MOVE:
+        stage = GENERATE_CAPTURES;
+        return tt_move;
+
+    case GENERATE_CAPTURES:
+    case QS_GENERATE_CAPTURES:
+        moves = board.generate_moves(board.get_side(), GEN_CAPTURES);
+        if (rotation && moves.size())
+        {
+            // changes the order moves with equal scores come out in
+            std::rotate(moves.begin(), moves.begin() + rotation % moves.size(), moves.end());
+        }
+        score_captures();
+        current = 0;
+        stage = stage == GENERATE_CAPTURES ? GOOD_CAPTURES : QS_CAPTURES;
+        return next_move();
+
+    case GOOD_CAPTURES:
+        while (current < moves.size())
+        {
+            move = select_best();
+            if (move == tt_move)
+            {
+                continue;
+            }
+            if (!board.see_ge(move, 0))
+            {
+                bad_captures.push_back(move); // tried after the quiets
+                continue;
+            }
+            return move;
+        }
+        stage = KILLERS;
+        return next_move();
+
+    case KILLERS:
+        while (refutation_index < 3)
+        {
+            move = refutations[refutation_index++];
+            bool duplicate = (refutation_index > 1 && move == refutations[0]) ||
+                             (refutation_index > 2 && move == refutations[1]);
+            if (!move || duplicate || move == tt_move || is_tactical(move))
+            {
+                continue;
+            }
+            if (board.is_pseudo_legal(move) && board.is_legal(move))
+            {
+                return move;
+            }
+        }
+        stage = GENERATE_QUIETS;
+        return next_move();
+
+    case GENERATE_QUIETS:
+        moves = board.generate_moves(board.get_side(), GEN_QUIETS);
+        if (rotation && moves.size())
+        {
+            std::rotate(moves.begin(), moves.begin() + rotation % moves.size(), moves.end());
+        }
+        score_quiets();
+        current = 0;
+        stage = QUIETS;
+        return next_move();
+
+    case QUIETS:
+        while (current < moves.size())
+        {
+            move = select_best();
+            if (move != tt_move && move != refutations[0] && move != refutations[1] && move != refutations[2])
+            {
+                return move;
+            }
+        }
+        current = 0;
+        stage = BAD_CAPTURES;
+        return next_move();
+
+    case BAD_CAPTURES:
+        if (current < bad_captures.size())
+        {
+            return bad_captures[current++];
+        }
+        stage = DONE;
+        return 0;
+
+    case QS_CAPTURES:
+        if (current < moves.size())
+        {
+            return select_best();
+        }
+        if (quiet_checks)
+        {
+            stage = QS_GENERATE_QUIET_CHECKS;
+            return next_move();
+        }
+        stage = DONE;
+        return 0;
+
+    case QS_GENERATE_QUIET_CHECKS:
+        moves = board.generate_moves(board.get_side(), GEN_QUIET_CHECKS);
+        score_quiets();
+        current = 0;
+        stage = QS_QUIET_CHECKS;
+        return next_move();
+
+    case QS_QUIET_CHECKS:
+        if (current < moves.size())
+        {
+            return select_best();
+        }
+        stage = DONE;
+        return 0;
+
+    case DONE:
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/nnue.hpp"
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+void *NNUE::mapping = nullptr;
+const int16_t *NNUE::feature_biases;
+const int16_t *NNUE::feature_weights;
+const int32_t *NNUE::hidden1_biases;
+const int8_t *NNUE::hidden1_weights;
+const int32_t *NNUE::hidden2_biases;
+const int8_t *NNUE::hidden2_weights;
+const int32_t *NNUE::output_bias;
+const int8_t *NNUE::output_weights;
+
+static constexpr int HIDDEN_SHIFT = 6;  // hidden layer sums are scaled by 64
+static constexpr int OUTPUT_SCALE = 16; // network output units per centipawn
+
+/*
+ * Maps the file read only and points the layers into the mapping, so the
+ * pages are shared by every process that loads the same network and only
+ * the rows actually used get read from disk.
+ */
+bool NNUE::load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size == FILE_SIZE)
+    {
+        data = mmap(nullptr, FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const char *bytes = (const char *)data;
+    uint32_t version;
+    memcpy(&version, bytes + 4, sizeof(version));
+    if (memcmp(bytes, "NNUE", 4) != 0 || version != VERSION)
+    {
+        munmap(data, FILE_SIZE);
+        return false;
+    }
+
+    unload();
+    mapping = data;
+    const char *p = bytes + 64;
+    feature_biases = (const int16_t *)p;
+    p += 2 * HALF;
+    feature_weights = (const int16_t *)p;
+    p += 2 * (size_t)INPUTS * HALF;
+    hidden1_biases = (const int32_t *)p;
+    p += 4 * HIDDEN1;
+    hidden1_weights = (const int8_t *)p;
+    p += HIDDEN1 * 2 * HALF;
+    hidden2_biases = (const int32_t *)p;
+    p += 4 * HIDDEN2;
+    hidden2_weights = (const int8_t *)p;
+    p += HIDDEN2 * HIDDEN1;
+    output_bias = (const int32_t *)p;
+    p += 64;
+    output_weights = (const int8_t *)p;
+    return true;
+}
+
+void NNUE::unload()
+{
+    if (mapping)
+    {
+        munmap(mapping, FILE_SIZE);
+        mapping = nullptr;
+    }
+}
+
+bool NNUE::loaded()
+{
+    return mapping != nullptr;
+}
+
+// squares are mirrored vertically for black, so both perspectives see their own king on the first ranks
+int NNUE::feature(Color perspective, Square king, Color color, PieceType type, Square square)
+{
+    int flip = perspective == WHITE ? 0 : 56;
+    int piece = (type - 1) * 2 + (color != perspective);
+    return (king ^ flip) * PIECE_FEATURES + piece * 64 + (square ^ flip);
+}
+
+/*
+ * out = in + sum of the added rows - sum of the removed rows, one pass over
+ * the 256 values with everything kept in registers per chunk.
+ */
+static void add_rows(int16_t *out, const int16_t *in, const int16_t *const *added, int added_count,
+                     const int16_t *const *removed, int removed_count)
+{
+#if defined(__AVX2__)
+    for (int i = 0; i < NNUE::HALF; i += 16)
+    {
+        __m256i sum = _mm256_load_si256((const __m256i *)(in + i));
+        for (int j = 0; j < added_count; j++)
+            sum = _mm256_add_epi16(sum, _mm256_load_si256((const __m256i *)(added[j] + i)));
+        for (int j = 0; j < removed_count; j++)
+            sum = _mm256_sub_epi16(sum, _mm256_load_si256((const __m256i *)(removed[j] + i)));
+        _mm256_store_si256((__m256i *)(out + i), sum);
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < NNUE::HALF; i += 8)
+    {
+        __m128i sum = _mm_load_si128((const __m128i *)(in + i));
+        for (int j = 0; j < added_count; j++)
+            sum = _mm_add_epi16(sum, _mm_load_si128((const __m128i *)(added[j] + i)));
+        for (int j = 0; j < removed_count; j++)
+            sum = _mm_sub_epi16(sum, _mm_load_si128((const __m128i *)(removed[j] + i)));
+        _mm_store_si128((__m128i *)(out + i), sum);
+    }
+#else
+    for (int i = 0; i < NNUE::HALF; i++)
+    {
+        int16_t sum = in[i];
+        for (int j = 0; j < added_count; j++)
+            sum += added[j][i];
+        for (int j = 0; j < removed_count; j++)
+            sum -= removed[j][i];
+        out[i] = sum;
+    }
+#endif
+}
+
+// int16 -> uint8 clamped to [0, 127], count a multiple of 32
+static void clip(uint8_t *out, const int16_t *in, int count)
+{
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256(), max = _mm256_set1_epi16(127);
+    for (int i = 0; i < count; i += 32)
+    {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i *)(in + i)), zero), max);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i *)(in + i + 16)), zero), max);
+        // packus works per 128 bit lane, the permute puts the quarters back in order
+        _mm256_store_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128(), max = _mm_set1_epi16(127);
+    for (int i = 0; i < count; i += 16)
+    {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i *)(in + i)), zero), max);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i *)(in + i + 8)), zero), max);
+        _mm_store_si128((__m128i *)(out + i), _mm_packus_epi16(a, b));
+    }
+#else
+    for (int i = 0; i < count; i++)
+        out[i] = in[i] < 0 ? 0 : in[i] > 127 ? 127 : in[i];
+#endif
+}
+
+/*
+ * out[o] = bias[o] + sum over i of weights[o][i] * in[i], inputs a multiple
+ * of 32. maddubs multiplies unsigned activations by signed weights and adds
+ * neighbouring pairs into int16, which can't overflow with activations <= 127.
+ */
+static void affine(int32_t *out, const uint8_t *in, int inputs, const int8_t *weights, const int32_t *biases, int outputs)
+{
+#if defined(__AVX2__)
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < outputs; o++)
+    {
+        const int8_t *row = weights + o * inputs;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < inputs; i += 32)
+        {
+            __m256i product = _mm256_maddubs_epi16(_mm256_load_si256((const __m256i *)(in + i)),
+                                                   _mm256_load_si256((const __m256i *)(row + i)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+        out[o] = biases[o] + _mm_cvtsi128_si32(half);
+    }
+#elif defined(__SSSE3__)
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int o = 0; o < outputs; o++)
+    {
+        const int8_t *row = weights + o * inputs;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < inputs; i += 16)
+        {
+            __m128i product = _mm_maddubs_epi16(_mm_load_si128((const __m128i *)(in + i)),
+                                                _mm_load_si128((const __m128i *)(row + i)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(product, ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+        out[o] = biases[o] + _mm_cvtsi128_si32(sum);
+    }
+#else
+    for (int o = 0; o < outputs; o++)
+    {
+        const int8_t *row = weights + o * inputs;
+        int32_t sum = biases[o];
+        for (int i = 0; i < inputs; i++)
+            sum += row[i] * in[i];
+        out[o] = sum;
+    }
+#endif
+}
+
+void NNUE::refresh(Accumulator &accumulator, Color perspective, const u64 pieces[2][7])
+{
+    Square king = (Square)__builtin_ctzll(pieces[perspective][KING]);
+    const int16_t *rows[30]; // at most 30 pieces besides the kings
+    int count = 0;
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+        for (int type = PAWN; type <= QUEEN; type++)
+        {
+            for (u64 bitboard = pieces[color][type]; bitboard; bitboard &= bitboard - 1)
+            {
+                int index = feature(perspective, king, (Color)color, (PieceType)type, (Square)__builtin_ctzll(bitboard));
+                rows[count++] = feature_weights + (size_t)index * HALF;
+            }
+        }
+    }
+    add_rows(accumulator.values[perspective], feature_biases, rows, count, nullptr, 0);
+}
+
+void NNUE::update(const Accumulator &previous, Accumulator &next, const AccumulatorDelta &delta, const u64 pieces[2][7])
+{
+    for (Color perspective : {WHITE, BLACK})
+    {
+        Square king = (Square)__builtin_ctzll(pieces[perspective][KING]);
+        const int16_t *added[4], *removed[4];
+        int added_count = 0, removed_count = 0;
+        bool king_moved = false;
+        for (int i = 0; i < delta.count; i++)
+        {
+            if (delta.type[i] == KING)
+            {
+                king_moved |= delta.color[i] == perspective;
+                continue; // kings are part of the feature index, not features themselves
+            }
+            const int16_t *row = feature_weights + (size_t)feature(perspective, king, delta.color[i], delta.type[i], delta.square[i]) * HALF;
+            if (delta.sign[i] > 0)
+                added[added_count++] = row;
+            else
+                removed[removed_count++] = row;
+        }
+        if (king_moved)
+        {
+            refresh(next, perspective, pieces);
+        }
+        else
+        {
+            add_rows(next.values[perspective], previous.values[perspective], added, added_count, removed, removed_count);
+        }
+    }
+}
+
+int NNUE::evaluate(const Accumulator &accumulator, Color side)
+{
+    alignas(64) uint8_t input[2 * HALF];
+    alignas(64) int32_t hidden1[HIDDEN1], hidden2[HIDDEN2];
+    alignas(64) uint8_t activations1[HIDDEN1], activations2[HIDDEN2];
+
+    clip(input, accumulator.values[side], HALF);
+    clip(input + HALF, accumulator.values[side == WHITE ? BLACK : WHITE], HALF);
+
+    affine(hidden1, input, 2 * HALF, hidden1_weights, hidden1_biases, HIDDEN1);
+    for (int i = 0; i < HIDDEN1; i++)
+        activations1[i] = std::min(std::max(hidden1[i] >> HIDDEN_SHIFT, 0), 127);
+
+    affine(hidden2, activations1, HIDDEN1, hidden2_weights, hidden2_biases, HIDDEN2);
+    for (int i = 0; i < HIDDEN2; i++)
+        activations2[i] = std::min(std::max(hidden2[i] >> HIDDEN_SHIFT, 0), 127);
+
+    int32_t output = *output_bias;
+    for (int i = 0; i < HIDDEN2; i++)
+        output += output_weights[i] * activations2[i];
+    return output / OUTPUT_SCALE;
+}
@@ -0,0 +1,132 @@
+#include "../include/pawns.hpp"
+
+static constexpr u64 FILE_A = 0x0101010101010101ULL;
+static constexpr u64 FILE_H = FILE_A << 7;
+
+// square indices grow towards rank 1, so white moves towards lower bits
+static u64 fill_up(u64 b)
+{
+    b |= b >> 8;
+    b |= b >> 16;
+    return b | b >> 32;
+}
+
+static u64 fill_down(u64 b)
+{
+    b |= b << 8;
+    b |= b << 16;
+    return b | b << 32;
+}
+
+static u64 shift_west(u64 b)
+{
+    return (b >> 1) & ~FILE_H;
+}
+
+static u64 shift_east(u64 b)
+{
+    return (b << 1) & ~FILE_A;
+}
+
+static u64 pawn_attacks(Color color, u64 pawns)
+{
+    u64 forward = color == WHITE ? pawns >> 8 : pawns << 8;
+    return shift_west(forward) | shift_east(forward);
+}
+
+// squares in front of the pawns on their own files, the pawns themselves excluded
+static u64 front_span(Color color, u64 pawns)
+{
+    return color == WHITE ? fill_up(pawns >> 8) : fill_down(pawns << 8);
+}
+
+static Score sum(u64 pawns, Score term)
+{
+    return __builtin_popcountll(pawns) * term;
+}
+
+PawnTable::PawnTable() : entries(SIZE)
+{
+}
+
+// which pawns the structure terms apply to; also what the tuner counts
+PawnTerms PawnTable::classify(u64 white_pawns, u64 black_pawns)
+{
+    u64 pawns[2] = {white_pawns, black_pawns};
+    PawnTerms terms;
+    for (Color color : {WHITE, BLACK})
+    {
+        Color enemy = color == WHITE ? BLACK : WHITE;
+        u64 own = pawns[color];
+        u64 files = fill_up(own) | fill_down(own);
+        u64 enemy_attacks = pawn_attacks(enemy, pawns[enemy]);
+        u64 enemy_span = pawn_attacks(enemy, pawns[enemy] | front_span(enemy, pawns[enemy]));
+
+        // pawns with another pawn of the same color in front of them
+        terms.doubled[color] = own & front_span(color, own);
+        terms.isolated[color] = own & ~(shift_west(files) | shift_east(files));
+
+        // no neighbour level with or behind it that could ever defend it, and it can't advance safely
+        u64 supportable = color == WHITE ? fill_up(own) : fill_down(own);
+        u64 stop_attacked = color == WHITE ? enemy_attacks << 8 : enemy_attacks >> 8;
+        terms.backward[color] = own & ~(shift_west(supportable) | shift_east(supportable)) & stop_attacked & ~terms.isolated[color];
+
+        // nothing of the enemy's in front on its own or a neighbouring file, and not behind a friendly pawn
+        terms.passed[color] = own & ~front_span(enemy, pawns[enemy]) & ~enemy_span & ~terms.doubled[color];
+    }
+    return terms;
+}
+
+void PawnTable::evaluate(u64 white_pawns, u64 black_pawns, PawnEntry &entry)
+{
+    u64 pawns[2] = {white_pawns, black_pawns};
+    PawnTerms terms = classify(white_pawns, black_pawns);
+
+    entry.score = 0;
+    for (Color color : {WHITE, BLACK})
+    {
+        entry.attacks[color] = pawn_attacks(color, pawns[color]);
+        entry.attack_span[color] = pawn_attacks(color, pawns[color] | front_span(color, pawns[color]));
+        entry.passed[color] = terms.passed[color];
+
+        Score score = sum(terms.doubled[color], DOUBLED) + sum(terms.isolated[color], ISOLATED) + sum(terms.backward[color], BACKWARD);
+        for (u64 passed = terms.passed[color]; passed; passed &= passed - 1)
+        {
+            int square = __builtin_ctzll(passed);
+            score += PASSED[color == WHITE ? 7 - square / 8 : square / 8];
+        }
+        entry.score += color == WHITE ? score : -score;
+    }
+}
+
+PawnEntry *PawnTable::probe(Board &board)
+{
+    u64 key = board.get_pawn_key();
+    PawnEntry &entry = entries[key & (SIZE - 1)];
+    probes++;
+    if (entry.key == key)
+    {
+        hits++;
+        return &entry;
+    }
+
+    entry.key = key;
+    evaluate(board.get_pieces(WHITE, PAWN), board.get_pieces(BLACK, PAWN), entry);
+    return &entry;
+}
+
+void PawnTable::clear()
+{
+    std::fill(entries.begin(), entries.end(), PawnEntry());
+}
+
+void PawnTable::reset_stats()
+{
+    probes = 0;
+    hits = 0;
+}
+
+double PawnTable::hit_rate()
+{
+    return probes ? (double)hits / probes : 0;
+}
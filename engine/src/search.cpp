@@ -0,0 +1,673 @@
+#include "../include/search.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <chrono>
+#include <thread>
+
+// mate scores are stored relative to the node so they stay valid at other plies
+static int score_to_tt(int score, int ply)
+{
+    return score >= MATE_BOUND ? score + ply : score <= -MATE_BOUND ? score - ply : score;
+}
+
+static int score_from_tt(int score, int ply)
+{
+    return score >= MATE_BOUND ? score - ply : score <= -MATE_BOUND ? score + ply : score;
+}
+
+int Search::reductions[64][64];
+
+// reductions grow with the log of both the remaining depth and how late the move comes
+void Search::init_reductions()
+{
+    static bool initialized = false;
+    if (initialized)
+    {
+        return;
+    }
+    for (int depth = 1; depth < 64; depth++)
+    {
+        for (int move_count = 1; move_count < 64; move_count++)
+        {
+            reductions[depth][move_count] = (int)(0.75 + std::log(depth) * std::log(move_count) / 2.25);
+        }
+    }
+    initialized = true;
+}
+
+Search::Search(TranspositionTable &tt, int thread_count) : tt(tt)
+{
+    init_reductions();
+    set_threads(thread_count);
+}
+
+void Search::set_threads(int count)
+{
+    threads.clear();
+    for (int i = 0; i < std::max(count, 1); i++)
+    {
+        threads.push_back(std::make_unique<SearchThread>());
+        threads.back()->id = i;
+    }
+}
+
+int Search::get_threads()
+{
+    return threads.size();
+}
+
+// forget cached evaluations, needed when the evaluation itself changes (another network)
+void Search::clear_eval_caches()
+{
+    for (auto &thread : threads)
+    {
+        thread->evaluator.clear_cache();
+    }
+}
+
+// safe to call from another thread while go() is running
+void Search::request_stop()
+{
+    stop = true;
+}
+
+// the opponent played the move we were pondering on: from now on the time limits apply
+void Search::ponderhit()
+{
+    pondering = false;
+}
+
+SearchResult Search::go(Board &board, SearchLimits limits)
+{
+    start(board, limits);
+    return run();
+}
+
+/*
+ * Sets up a search without running it: resets the stop flag, starts the clock
+ * and hands every thread a copy of the position. Done on the caller's thread so
+ * a stop that arrives before run() gets going is not lost.
+ */
+void Search::start(Board &board, SearchLimits limits)
+{
+    tt.new_search();
+    stop = false;
+    pondering = limits.ponder;
+    Color side = board.get_side();
+    if (limits.infinite)
+    {
+        time_manager.start(0, 0, 0, 0);
+    }
+    else
+    {
+        time_manager.start(limits.time[side], limits.increment[side], limits.movestogo, limits.movetime);
+    }
+    node_limit = limits.infinite ? 0 : limits.nodes;
+
+    for (auto &thread : threads)
+    {
+        thread->board = board;
+        thread->nodes = 0;
+        thread->qnodes = 0;
+        thread->beta_cutoffs = 0;
+        thread->first_move_cutoffs = 0;
+        thread->null_cutoffs = 0;
+        thread->pvs_researches = 0;
+        thread->aspiration_researches = 0;
+        thread->evaluator.reset_stats();
+        thread->history.clear();
+        thread->completed_depth = 0;
+        thread->best_move = 0;
+        thread->ponder_move = 0;
+        thread->best_score = -INFINITE_SCORE;
+    }
+    search_limits = limits;
+}
+
+// runs the search set up by start() on the calling thread plus the helpers
+SearchResult Search::run()
+{
+    SearchLimits limits = search_limits;
+
+    // helpers keep deepening until the main thread is done
+    SearchLimits helper_limits = limits;
+    helper_limits.depth = MAX_PLY - 1;
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < threads.size(); i++)
+    {
+        helpers.emplace_back([this, i, helper_limits]
+                             { iterative_deepening(*threads[i], helper_limits); });
+    }
+
+    iterative_deepening(*threads[0], limits);
+
+    // an infinite or ponder search may not answer before it is told to, even once it has hit its depth limit
+    while (!stop.load(std::memory_order_relaxed) && (limits.infinite || pondering.load(std::memory_order_relaxed)))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stop = true;
+    for (std::thread &helper : helpers)
+    {
+        helper.join();
+    }
+
+    SearchThread &best = pick_best_thread();
+    SearchResult result;
+    result.best_move = best.best_move;
+    result.ponder_move = best.ponder_move;
+    result.score = best.best_score;
+    result.depth = best.completed_depth;
+    if (!result.best_move)
+    {
+        // stopped before any iteration finished, still answer with a legal move
+        vector<int> moves = threads[0]->board.generate_legal_moves(threads[0]->board.get_side());
+        result.best_move = moves.empty() ? 0 : moves[0];
+    }
+    for (auto &thread : threads)
+    {
+        result.nodes += thread->nodes.load(std::memory_order_relaxed);
+        result.qnodes += thread->qnodes.load(std::memory_order_relaxed);
+        result.beta_cutoffs += thread->beta_cutoffs;
+        result.first_move_cutoffs += thread->first_move_cutoffs;
+        result.null_cutoffs += thread->null_cutoffs;
+        result.pvs_researches += thread->pvs_researches;
+        result.aspiration_researches += thread->aspiration_researches;
+        result.pawn_probes += thread->evaluator.pawn_table.probes;
+        result.pawn_hits += thread->evaluator.pawn_table.hits;
+        result.eval_probes += thread->evaluator.cache_probes;
+        result.eval_hits += thread->evaluator.cache_hits;
+        result.lazy_evals += thread->evaluator.lazy_exits;
+    }
+    return result;
+}
+
+/*
+ * From depth 4 on each iteration starts with an aspiration window around the
+ * previous score. A search that fails outside it is repeated with the window
+ * doubled on the failing side, until the score lands inside.
+ */
+void Search::iterative_deepening(SearchThread &thread, SearchLimits limits)
+{
+    int score = 0;
+    int stability = 0; // iterations the best move has stayed the same
+    // odd helpers start one ply ahead so the threads aren't searching the same depth in lockstep
+    for (int depth = 1 + (thread.id & 1); depth <= limits.depth; depth++)
+    {
+        int delta = 25;
+        int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        if (depth >= 4 && std::abs(score) < MATE_BOUND)
+        {
+            alpha = std::max(score - delta, -INFINITE_SCORE);
+            beta = std::min(score + delta, INFINITE_SCORE);
+        }
+
+        while (true)
+        {
+            score = negamax(thread, alpha, beta, depth, 0);
+            if (stop.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            if (score <= alpha)
+            {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            }
+            else if (score >= beta)
+            {
+                beta = std::min(score + delta, INFINITE_SCORE);
+            }
+            else
+            {
+                break;
+            }
+            thread.aspiration_researches++;
+            delta *= 2;
+        }
+
+        if (stop.load(std::memory_order_relaxed))
+        {
+            break; // iteration was cut short, keep the previous result
+        }
+        int previous_move = thread.best_move, previous_score = thread.best_score;
+        thread.completed_depth = depth;
+        thread.best_score = score;
+        thread.best_move = thread.pv_length[0] > 0 ? thread.pv[0][0] : 0;
+        thread.ponder_move = thread.pv_length[0] > 1 ? thread.pv[0][1] : 0;
+        if (!thread.best_move)
+        {
+            break; // no legal moves at the root
+        }
+
+        if (thread.id == 0 && on_iteration)
+        {
+            SearchInfo info;
+            info.depth = depth;
+            info.score = score;
+            for (auto &t : threads)
+            {
+                info.nodes += t->nodes.load(std::memory_order_relaxed);
+            }
+            info.time = time_manager.elapsed();
+            info.hashfull = tt.hashfull();
+            info.pv.assign(thread.pv[0], thread.pv[0] + thread.pv_length[0]);
+            on_iteration(info);
+        }
+
+        // the main thread decides whether another iteration fits in the time left
+        stability = thread.best_move == previous_move ? stability + 1 : 0;
+        int score_drop = depth > 1 ? previous_score - score : 0;
+        if (thread.id == 0 && !pondering.load(std::memory_order_relaxed) && time_manager.soft_limit_reached(stability, score_drop))
+        {
+            break;
+        }
+    }
+}
+
+int Search::negamax(SearchThread &thread, int alpha, int beta, int depth, int ply)
+{
+    Board &board = thread.board;
+    thread.pv_length[ply] = ply;
+
+    if (stop.load(std::memory_order_relaxed))
+    {
+        return 0;
+    }
+    if (depth <= 0)
+    {
+        return quiescence(thread, alpha, beta, ply, 0);
+    }
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (thread.id == 0)
+    {
+        poll_limits(thread);
+    }
+    if (ply >= MAX_PLY - 1)
+    {
+        return evaluate(thread);
+    }
+
+    int alpha_orig = alpha;
+    u64 key = board.get_hash();
+    int tt_move = 0, tt_score = 0, tt_depth = 0;
+    Bound tt_bound = BOUND_NONE;
+    if (tt.probe(key, tt_move, tt_score, tt_depth, tt_bound))
+    {
+        tt_score = score_from_tt(tt_score, ply);
+        if (ply > 0 && tt_depth >= depth &&
+            (tt_bound == BOUND_EXACT ||
+             (tt_bound == BOUND_LOWER && tt_score >= beta) ||
+             (tt_bound == BOUND_UPPER && tt_score <= alpha)))
+        {
+            return tt_score;
+        }
+    }
+
+    bool in_check = board.in_check();
+    bool pv_node = beta - alpha > 1;
+    int static_eval = in_check ? -INFINITE_SCORE : evaluate(thread);
+
+    // reverse futility: far enough above beta that a shallow search won't bring it back down
+    if (options.reverse_futility && !pv_node && !in_check && depth <= 6 &&
+        std::abs(beta) < MATE_BOUND && static_eval - 90 * depth >= beta)
+    {
+        return static_eval;
+    }
+
+    // razoring: hopelessly below alpha near the leaves, check that captures can't save it
+    if (options.razoring && !pv_node && !in_check && depth <= 2 && static_eval + 300 * depth < alpha)
+    {
+        int score = quiescence(thread, alpha - 1, alpha, ply, 0);
+        if (score < alpha)
+        {
+            return score;
+        }
+    }
+
+    /*
+     * Null move pruning: give the opponent a free move and search the result
+     * with a reduced depth. If we still fail high the real moves will too.
+     * Skipped in check, right after another null move, and when the side to
+     * move has only pawns left, where zugzwang makes passing unrealistically good.
+     */
+    if (options.null_move && ply > 0 && depth >= 3 && !in_check && board.last_move() && beta < MATE_BOUND &&
+        board.non_pawn_material(board.get_side()) > 0 && static_eval >= beta)
+    {
+        int reduction = 3 + depth / 6;
+        board.make_null_move();
+        int null_score = -negamax(thread, -beta, -beta + 1, depth - 1 - reduction, ply + 1);
+        board.unmake_null_move();
+
+        if (stop.load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+        if (null_score >= beta)
+        {
+            thread.null_cutoffs++;
+            return null_score >= MATE_BOUND ? beta : null_score; // don't trust mates found by passing
+        }
+    }
+
+    // helpers see equally scored root moves in a different order than the main thread
+    MovePicker picker(board, thread.history, tt_move, ply, ply == 0 ? thread.id : 0);
+
+    int best_score = -INFINITE_SCORE, best_move = 0, move_count = 0;
+    int quiets_tried[64], quiet_count = 0;
+    int move;
+    while ((move = picker.next_move()))
+    {
+        move_count++;
+        bool is_quiet = !((move >> 15) & 0b111) && ((move >> 21) & 0b111) != 2 && ((move >> 18) & 0b111) != QUEEN;
+        bool gives_check = board.gives_check(move);
+
+        // shallow pruning of quiets, only once a move has been searched so mates are still found
+        if (!pv_node && !in_check && is_quiet && !gives_check && best_score > -MATE_BOUND)
+        {
+            // late move pruning: with good ordering the tail of the quiet list almost never raises alpha
+            if (options.late_move_pruning && depth <= 4 && move_count > 3 + depth * depth)
+            {
+                continue;
+            }
+            // futility: even a generous positional gain can't lift the static eval to alpha
+            if (options.futility && depth <= 3 && static_eval + 100 + 120 * depth <= alpha)
+            {
+                continue;
+            }
+        }
+
+        board.make_move(move);
+        int score;
+        if (move_count == 1)
+        {
+            score = -negamax(thread, -beta, -alpha, depth - 1, ply + 1);
+        }
+        else
+        {
+            /*
+             * Principal variation search: every move after the first only has to
+             * prove it is no better than alpha, which a null window does cheaply.
+             * Late quiets are also reduced (LMR); a move that beats alpha anyway is
+             * searched again at full depth, and in PV nodes with the full window.
+             */
+            int reduction = 0;
+            if (options.late_move_reductions && depth >= 3 && is_quiet && !in_check)
+            {
+                reduction = reductions[std::min(depth, 63)][std::min(move_count, 63)] - pv_node - gives_check;
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
+            score = -negamax(thread, -alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+            if (score > alpha && reduction > 0)
+            {
+                score = -negamax(thread, -alpha - 1, -alpha, depth - 1, ply + 1);
+            }
+            if (score > alpha && score < beta)
+            {
+                thread.pvs_researches++;
+                score = -negamax(thread, -beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+        board.unmake_move();
+
+        if (stop.load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_move = move;
+            if (score > alpha)
+            {
+                alpha = score;
+
+                // copy the child's pv behind this move
+                thread.pv[ply][ply] = move;
+                for (int i = ply + 1; i < thread.pv_length[ply + 1]; i++)
+                {
+                    thread.pv[ply][i] = thread.pv[ply + 1][i];
+                }
+                thread.pv_length[ply] = std::max(thread.pv_length[ply + 1], ply + 1);
+
+                if (alpha >= beta)
+                {
+                    thread.beta_cutoffs++;
+                    thread.first_move_cutoffs += move_count == 1;
+                    if (is_quiet)
+                    {
+                        update_quiet_stats(thread, move, depth, ply, quiets_tried, quiet_count);
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (is_quiet && quiet_count < 64)
+        {
+            quiets_tried[quiet_count++] = move;
+        }
+    }
+
+    if (move_count == 0)
+    {
+        return in_check ? -MATE_SCORE + ply : 0;
+    }
+
+    Bound bound = best_score >= beta ? BOUND_LOWER : best_score > alpha_orig ? BOUND_EXACT
+                                                                             : BOUND_UPPER;
+    tt.store(key, best_move, score_to_tt(best_score, ply), depth, bound);
+
+    return best_score;
+}
+
+/*
+ * Resolves captures (and queen promotions) until the position is quiet so the
+ * static eval is never taken in the middle of an exchange. The side to move
+ * may stand pat on the static eval unless it is in check, in which case every
+ * evasion is searched. On the first quiescence ply (depth 0) quiet checks are
+ * tried after the captures so short mating attacks aren't cut off by stand pat.
+ */
+int Search::quiescence(SearchThread &thread, int alpha, int beta, int ply, int depth)
+{
+    Board &board = thread.board;
+    thread.pv_length[ply] = ply;
+
+    if (stop.load(std::memory_order_relaxed))
+    {
+        return 0;
+    }
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (thread.id == 0)
+    {
+        poll_limits(thread);
+    }
+    thread.qnodes.store(thread.qnodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (ply >= MAX_PLY - 1)
+    {
+        return evaluate(thread);
+    }
+
+    int best_score = -INFINITE_SCORE;
+    bool in_check = board.in_check();
+    if (!in_check)
+    {
+        int stand_pat = evaluate(thread, alpha, beta);
+        if (stand_pat >= beta)
+        {
+            return stand_pat;
+        }
+        alpha = std::max(alpha, stand_pat);
+        best_score = stand_pat;
+    }
+
+    // in check every evasion is searched, otherwise only captures and queen promotions
+    MovePicker picker = in_check ? MovePicker(board, thread.history, 0, ply) : MovePicker(board, thread.history, depth == 0);
+    int move, move_count = 0;
+    while ((move = picker.next_move()))
+    {
+        move_count++;
+
+        // captures that lose material can't raise a stand pat score
+        if (!in_check && !board.see_ge(move, 0))
+        {
+            continue;
+        }
+
+        board.make_move(move);
+        int score = -quiescence(thread, -beta, -alpha, ply + 1, depth - 1);
+        board.unmake_move();
+
+        if (stop.load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (in_check && move_count == 0)
+    {
+        return -MATE_SCORE + ply;
+    }
+
+    return best_score;
+}
+
+/*
+ * A quiet move caused a beta cutoff: make it a killer and the countermove to
+ * the previous move, reward it in the history table and penalise the quiets
+ * that were searched before it without cutting off.
+ */
+void Search::update_quiet_stats(SearchThread &thread, int move, int depth, int ply, int *quiets_tried, int quiet_count)
+{
+    MoveHistory &history = thread.history;
+    Color color = thread.board.get_side();
+    int bonus = depth * depth;
+
+    history.update_killer(ply, move);
+    int previous = thread.board.last_move();
+    if (previous)
+    {
+        history.countermoves[(previous >> 12) & 0b111][(previous >> 6) & 0x3f] = move;
+    }
+
+    history.update_quiet(color, move, bonus);
+    for (int i = 0; i < quiet_count; i++)
+    {
+        history.update_quiet(color, quiets_tried[i], -bonus);
+    }
+}
+
+/*
+ * Called by the main thread at every node. The node limit is a cheap compare,
+ * the clock is only read every POLL_INTERVAL nodes. Nothing is stopped before
+ * the first iteration is complete so there is always a move to play.
+ */
+void Search::poll_limits(SearchThread &thread)
+{
+    long nodes = thread.nodes.load(std::memory_order_relaxed);
+    if (thread.completed_depth == 0 || pondering.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    if ((node_limit && nodes >= node_limit) ||
+        ((nodes & (TimeManager::POLL_INTERVAL - 1)) == 0 && time_manager.hard_limit_reached()))
+    {
+        stop = true;
+    }
+}
+
+// static eval of the thread's board, from the side to move's point of view
+int Search::evaluate(SearchThread &thread)
+{
+    return thread.evaluator.evaluate(thread.board);
+}
+
+// the same, but allowed to stop at a material estimate when that is far outside (alpha, beta)
+int Search::evaluate(SearchThread &thread, int alpha, int beta)
+{
+    if (!options.lazy_eval)
+    {
+        return evaluate(thread);
+    }
+    return thread.evaluator.evaluate(thread.board, alpha, beta);
+}
+
+/*
+ * Every thread votes for its best move, weighted by how deep it got and how
+ * good its score is relative to the worst thread. The main thread wins ties.
+ */
+SearchThread &Search::pick_best_thread()
+{
+    SearchThread *best = threads[0].get();
+    if (threads.size() == 1)
+    {
+        return *best;
+    }
+
+    int min_score = INFINITE_SCORE;
+    for (auto &thread : threads)
+    {
+        if (thread->completed_depth)
+        {
+            min_score = std::min(min_score, thread->best_score);
+        }
+    }
+
+    std::map<int, long> votes;
+    for (auto &thread : threads)
+    {
+        if (thread->completed_depth)
+        {
+            votes[thread->best_move] += (long)(thread->best_score - min_score + 14) * thread->completed_depth;
+        }
+    }
+
+    for (auto &thread : threads)
+    {
+        if (thread->completed_depth && votes[thread->best_move] > votes[best->best_move])
+        {
+            best = thread.get();
+        }
+    }
+    return *best;
+}
+
+void Search::print_thread_breakdown()
+{
+    long total = 0;
+    for (auto &thread : threads)
+    {
+        total += thread->nodes.load(std::memory_order_relaxed);
+    }
+
+    for (auto &thread : threads)
+    {
+        long nodes = thread->nodes.load(std::memory_order_relaxed);
+        cout << "thread " << thread->id
+             << " nodes " << nodes
+             << " qnodes " << thread->qnodes.load(std::memory_order_relaxed)
+             << " (" << (total ? 100.0 * nodes / total : 0.0) << "%)"
+             << " depth " << thread->completed_depth
+             << " bestmove " << (thread->best_move ? thread->board.move_to_string(thread->best_move) : "none")
+             << " score " << thread->best_score
+             << " first move cutoffs " << (thread->beta_cutoffs ? 100.0 * thread->first_move_cutoffs / thread->beta_cutoffs : 0.0) << "%" << endl;
+    }
+}
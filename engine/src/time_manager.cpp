@@ -0,0 +1,75 @@
+#include "../include/time_manager.hpp"
+#include <algorithm>
+
+void TimeManager::start(int64_t time, int64_t increment, int moves_to_go, int64_t move_time)
+{
+    start_time = std::chrono::steady_clock::now();
+    enabled = move_time > 0 || time > 0;
+    fixed_time = move_time > 0;
+
+    if (move_time > 0)
+    {
+        soft_limit = hard_limit = std::max<int64_t>(1, move_time - MOVE_OVERHEAD);
+        return;
+    }
+    if (time <= 0)
+    {
+        soft_limit = hard_limit = 0;
+        return;
+    }
+
+    // spread what's left evenly over the moves to the next time control, plus most of the increment
+    int64_t available = std::max<int64_t>(1, time - MOVE_OVERHEAD);
+    int moves = moves_to_go > 0 ? std::min(moves_to_go, 50) : DEFAULT_MOVES_TO_GO;
+    soft_limit = available / moves + increment * 3 / 4;
+
+    // a single move may overrun its share but never eat into the next moves' time too much
+    hard_limit = std::min(soft_limit * 4, available / 2 + increment);
+    hard_limit = std::min(std::max<int64_t>(hard_limit, 1), available);
+    soft_limit = std::max<int64_t>(1, std::min(soft_limit, hard_limit));
+}
+
+int64_t TimeManager::elapsed()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+bool TimeManager::is_enabled()
+{
+    return enabled;
+}
+
+int64_t TimeManager::get_soft_limit()
+{
+    return soft_limit;
+}
+
+int64_t TimeManager::get_hard_limit()
+{
+    return hard_limit;
+}
+
+bool TimeManager::hard_limit_reached()
+{
+    return enabled && elapsed() >= hard_limit;
+}
+
+/*
+ * Whether to start another iteration. stability is the number of iterations
+ * the best move hasn't changed for, score_drop how far (cp) the score fell
+ * since the previous iteration. A stable move stops at down to half the soft
+ * limit, a falling score extends it up to 2x (the hard limit still applies).
+ */
+bool TimeManager::soft_limit_reached(int stability, int score_drop)
+{
+    if (!enabled || fixed_time)
+    {
+        return false; // a fixed move time runs until the hard limit
+    }
+    double scale = 1.2 - 0.1 * std::min(stability, 7);
+    if (score_drop > 0)
+    {
+        scale *= 1.0 + std::min(score_drop, 100) / 100.0;
+    }
+    return elapsed() >= soft_limit * scale;
+}
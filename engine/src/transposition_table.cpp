@@ -0,0 +1,107 @@
+#include "../include/transposition_table.hpp"
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    // round down to a power of two so the bucket index is a mask
+    size_t buckets = megabytes * 1024 * 1024 / (sizeof(TTEntry) * BUCKET_SIZE);
+    bucket_count = 1;
+    while (bucket_count * 2 <= buckets)
+    {
+        bucket_count *= 2;
+    }
+    table.reset(new TTEntry[bucket_count * BUCKET_SIZE]);
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucket_count * BUCKET_SIZE; i++)
+    {
+        table[i].key.store(0, std::memory_order_relaxed);
+        table[i].data.store(0, std::memory_order_relaxed);
+    }
+    generation = 0;
+}
+
+void TranspositionTable::new_search()
+{
+    generation = (generation + 1) & 0x3f;
+}
+
+bool TranspositionTable::probe(u64 key, int &move, int &score, int &depth, Bound &bound)
+{
+    TTEntry *bucket = &table[(key & (bucket_count - 1)) * BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; i++)
+    {
+        u64 data = bucket[i].data.load(std::memory_order_relaxed);
+        if ((bucket[i].key.load(std::memory_order_relaxed) ^ data) == key && data)
+        {
+            move = data & 0xffffff;
+            score = (int16_t)((data >> 24) & 0xffff);
+            depth = (data >> 40) & 0xff;
+            bound = (Bound)((data >> 48) & 0b11);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(u64 key, int move, int score, int depth, Bound bound)
+{
+    TTEntry *bucket = &table[(key & (bucket_count - 1)) * BUCKET_SIZE];
+    TTEntry *replace = &bucket[0];
+    int replace_value = 1 << 30;
+
+    for (int i = 0; i < BUCKET_SIZE; i++)
+    {
+        u64 data = bucket[i].data.load(std::memory_order_relaxed);
+        if ((bucket[i].key.load(std::memory_order_relaxed) ^ data) == key || !data)
+        {
+            // keep the old move if this store doesn't know a better one
+            if (!move && data)
+            {
+                move = data & 0xffffff;
+            }
+            replace = &bucket[i];
+            break;
+        }
+
+        // prefer overwriting shallow entries left over from older searches
+        int entry_depth = (data >> 40) & 0xff;
+        int entry_age = (generation - ((data >> 50) & 0x3f)) & 0x3f;
+        int value = entry_depth - 8 * entry_age;
+        if (value < replace_value)
+        {
+            replace_value = value;
+            replace = &bucket[i];
+        }
+    }
+
+    u64 data = (u64)(move & 0xffffff) |
+               ((u64)(uint16_t)score << 24) |
+               ((u64)(depth & 0xff) << 40) |
+               ((u64)bound << 48) |
+               (generation << 50);
+    replace->key.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+// permille of sampled entries written by the current search
+int TranspositionTable::hashfull()
+{
+    int used = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        u64 data = table[i].data.load(std::memory_order_relaxed);
+        if (data && ((data >> 50) & 0x3f) == generation)
+        {
+            used++;
+        }
+    }
+    return used;
+}
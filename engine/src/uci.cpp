@@ -0,0 +1,351 @@
+#include "../include/uci.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <mutex>
+
+static std::mutex output_mutex; // keeps lines from the search thread and the reader whole
+
+static void send(const string &line)
+{
+    std::lock_guard<std::mutex> lock(output_mutex);
+    cout << line << endl;
+}
+
+Uci::Uci() : tt(16), search(tt)
+{
+    board.load_fen(START_FEN);
+    position_fen = START_FEN;
+    search.on_iteration = [this](const SearchInfo &info)
+    { send_info(info); };
+}
+
+Uci::~Uci()
+{
+    search.request_stop();
+    wait_for_search();
+    if (reader_thread.joinable())
+    {
+        reader_thread.join();
+    }
+}
+
+// reader thread: applies the urgent commands immediately and queues everything
+void Uci::read_input(istream &input)
+{
+    string line, command;
+    while (getline(input, line))
+    {
+        istringstream tokens(line);
+        tokens >> command;
+        if (command == "stop" || command == "quit")
+        {
+            search.request_stop();
+        }
+        else if (command == "ponderhit")
+        {
+            search.ponderhit();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queue.push_back(line);
+        }
+        queue_ready.notify_one();
+        if (command == "quit")
+        {
+            return;
+        }
+    }
+
+    // end of input means quit
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back("quit");
+    }
+    search.request_stop();
+    queue_ready.notify_one();
+}
+
+string Uci::next_command()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_ready.wait(lock, [this]
+                     { return !queue.empty(); });
+    string line = queue.front();
+    queue.pop_front();
+    return line;
+}
+
+void Uci::loop(istream &input)
+{
+    reader_thread = std::thread([this, &input]
+                                { read_input(input); });
+
+    string command;
+    while (true)
+    {
+        string line = next_command();
+        istringstream tokens(line);
+        if (!(tokens >> command))
+        {
+            continue;
+        }
+
+        if (command == "uci")
+        {
+            send("id name chess-engine");
+            send("id author chess-engine authors");
+            send("option name Hash type spin default 16 min 1 max 65536");
+            send("option name Threads type spin default 1 min 1 max 256");
+            send("option name Ponder type check default false");
+            send("option name EvalFile type string default <empty>");
+            send("uciok");
+        }
+        else if (command == "isready")
+        {
+            send("readyok");
+        }
+        else if (command == "ucinewgame")
+        {
+            wait_for_search();
+            tt.clear();
+            position_fen.clear(); // next position command reloads from scratch
+        }
+        else if (command == "position")
+        {
+            wait_for_search();
+            position(tokens);
+        }
+        else if (command == "go")
+        {
+            wait_for_search();
+            go(tokens);
+        }
+        else if (command == "stop")
+        {
+            search.request_stop(); // bestmove comes from the search thread
+        }
+        else if (command == "ponderhit")
+        {
+            search.ponderhit();
+        }
+        else if (command == "setoption")
+        {
+            wait_for_search();
+            set_option(tokens);
+        }
+        else if (command == "quit")
+        {
+            break;
+        }
+        else if (command == "d")
+        {
+            board.print();
+        }
+        else
+        {
+            send("info string unknown command " + command);
+        }
+    }
+}
+
+/*
+ * position [startpos | fen <fen>] [moves <move>...]
+ * When the FEN is unchanged and the moves already played are a prefix of the
+ * new list, only the remaining moves are made.
+ */
+void Uci::position(istringstream &input)
+{
+    string token, fen;
+    input >> token;
+    if (token == "startpos")
+    {
+        fen = START_FEN;
+        input >> token; // "moves"
+    }
+    else if (token == "fen")
+    {
+        while (input >> token && token != "moves")
+        {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    vector<string> moves;
+    while (input >> token)
+    {
+        moves.push_back(token);
+    }
+
+    bool extends = fen == position_fen && moves.size() >= position_moves.size() &&
+                   std::equal(position_moves.begin(), position_moves.end(), moves.begin());
+    if (!extends)
+    {
+        board.load_fen(fen);
+        position_fen = fen;
+        position_moves.clear();
+    }
+
+    for (size_t i = position_moves.size(); i < moves.size(); i++)
+    {
+        int move = board.parse_move(moves[i]);
+        if (!move)
+        {
+            send("info string illegal move " + moves[i]);
+            break;
+        }
+        board.make_move(move);
+        position_moves.push_back(moves[i]);
+    }
+}
+
+// go [depth n] [nodes n] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo n] [infinite] [ponder]
+void Uci::go(istringstream &input)
+{
+    SearchLimits limits;
+    string token;
+    while (input >> token)
+    {
+        if (token == "depth")
+            input >> limits.depth;
+        else if (token == "nodes")
+            input >> limits.nodes;
+        else if (token == "movetime")
+            input >> limits.movetime;
+        else if (token == "wtime")
+            input >> limits.time[WHITE];
+        else if (token == "btime")
+            input >> limits.time[BLACK];
+        else if (token == "winc")
+            input >> limits.increment[WHITE];
+        else if (token == "binc")
+            input >> limits.increment[BLACK];
+        else if (token == "movestogo")
+            input >> limits.movestogo;
+        else if (token == "infinite")
+            limits.infinite = true;
+        else if (token == "ponder")
+            limits.ponder = true;
+    }
+    limits.depth = std::max(1, std::min(limits.depth, MAX_PLY - 1));
+
+    search.start(board, limits);
+    search_thread = std::thread([this]
+                                {
+        SearchResult result = search.run();
+        string line = "bestmove " + (result.best_move ? board.move_to_string(result.best_move) : string("0000"));
+        if (result.best_move && result.ponder_move)
+        {
+            line += " ponder " + board.move_to_string(result.ponder_move);
+        }
+        send(line); });
+}
+
+// a spin option's value clamped to the range it was advertised with, false if it isn't a number
+static bool parse_spin(const string &value, int min, int max, int &result)
+{
+    char *end;
+    long number = std::strtol(value.c_str(), &end, 10);
+    while (isspace((unsigned char)*end))
+    {
+        end++;
+    }
+    if (end == value.c_str() || *end)
+    {
+        return false;
+    }
+    result = (int)std::clamp<long>(number, min, max);
+    return true;
+}
+
+// setoption name <Hash|Threads|Ponder|EvalFile> value <value>
+void Uci::set_option(istringstream &input)
+{
+    string token, name, value;
+    input >> token; // "name"
+    while (input >> token && token != "value")
+    {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    getline(input >> std::ws, value); // file names may contain spaces
+
+    int number = 0;
+    if ((name == "Hash" || name == "Threads") &&
+        !parse_spin(value, 1, name == "Hash" ? 65536 : 256, number))
+    {
+        send("info string " + name + " needs a number, got " + value);
+    }
+    else if (name == "Hash")
+    {
+        tt.resize(number);
+    }
+    else if (name == "Threads")
+    {
+        search.set_threads(number);
+    }
+    else if (name == "Ponder")
+    {
+        // nothing to set up, pondering is driven by "go ponder" and "ponderhit"
+    }
+    else if (name == "EvalFile")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            NNUE::unload();
+        }
+        else if (!NNUE::load(value))
+        {
+            NNUE::unload(); // a failed load leaves the previous network mapped
+            send("info string could not load network " + value + ", using the classical evaluation");
+        }
+        tt.clear(); // scores stored under the old evaluation
+        search.clear_eval_caches();
+        board.sync_network(); // the search boards are copied from this one at the next go
+    }
+    else
+    {
+        send("info string unknown option " + name);
+    }
+}
+
+void Uci::wait_for_search()
+{
+    if (search_thread.joinable())
+    {
+        search_thread.join();
+    }
+}
+
+void Uci::send_info(const SearchInfo &info)
+{
+    ostringstream line;
+    line << "info depth " << info.depth
+         << " score " << score_to_string(info.score)
+         << " nodes " << info.nodes
+         << " nps " << info.nodes * 1000 / std::max<int64_t>(info.time, 1)
+         << " hashfull " << info.hashfull
+         << " time " << info.time
+         << " pv";
+    for (int move : info.pv)
+    {
+        line << " " << board.move_to_string(move);
+    }
+    send(line.str());
+}
+
+// centipawns, or moves to mate (negative when getting mated)
+string Uci::score_to_string(int score)
+{
+    if (std::abs(score) >= MATE_BOUND)
+    {
+        int plies = MATE_SCORE - std::abs(score);
+        int moves = (plies + 1) / 2;
+        return "mate " + to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + to_string(score);
+}
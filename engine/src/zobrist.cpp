@@ -0,0 +1,48 @@
+#include <mutex>
+#include "../include/zobrist.hpp"
+
+u64 Zobrist::seed;
+u64 Zobrist::piece_keys[2][7][64];
+u64 Zobrist::enpassant_keys[8];
+u64 Zobrist::castling_keys[16];
+u64 Zobrist::side_key;
+
+// xorshift64*
+u64 Zobrist::random_u64()
+{
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 0x2545f4914f6cdd1dULL;
+}
+
+// once only: boards on other threads may already be hashing with the keys
+void Zobrist::init()
+{
+    static std::once_flag once;
+    std::call_once(once, generate);
+}
+
+void Zobrist::generate()
+{
+    seed = 0x9e3779b97f4a7c15ULL;
+    for (int color = 0; color < 2; color++)
+    {
+        for (int piece = PAWN; piece <= KING; piece++)
+        {
+            for (int square = 0; square < BOARD_SIZE; square++)
+            {
+                piece_keys[color][piece][square] = random_u64();
+            }
+        }
+    }
+    for (int file = 0; file < 8; file++)
+    {
+        enpassant_keys[file] = random_u64();
+    }
+    for (int rights = 0; rights < 16; rights++)
+    {
+        castling_keys[rights] = random_u64();
+    }
+    side_key = random_u64();
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include "../include/board.hpp"
+#include <algorithm>
+#include <iomanip>
+
+/*
+ * Check evasion microbenchmark. Collects the in-check positions found in a
+ * shallow tree under a few tactical positions, then times generating all
+ * legal moves there with the evasion generator and with the general
+ * checkmask path, and checks that both produce the same moves.
+ *
+ * usage: evasion_bench [iterations]
+ */
+static void collect_checks(Board &board, int depth, vector<Board> &in_check)
+{
+    if (board.in_check())
+    {
+        in_check.push_back(board);
+    }
+    if (depth == 0)
+    {
+        return;
+    }
+    for (int move : board.generate_legal_moves(board.get_side()))
+    {
+        board.make_move(move);
+        collect_checks(board, depth - 1, in_check);
+        board.unmake_move();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r1bqk2r/pppp1Bpp/2n2n2/2b1p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 0 4",
+    };
+    int iterations = argc > 1 ? atoi(argv[1]) : 50;
+
+    vector<Board> boards;
+    for (const char *fen : positions)
+    {
+        Board board;
+        board.load_fen(fen);
+        collect_checks(board, 3, boards);
+    }
+
+    long mismatches = 0, moves = 0;
+    for (Board &board : boards)
+    {
+        vector<int> evasions = board.generate_moves(board.get_side(), GEN_ALL, true);
+        vector<int> general = board.generate_moves(board.get_side(), GEN_ALL, false);
+        sort(evasions.begin(), evasions.end());
+        sort(general.begin(), general.end());
+        mismatches += evasions != general;
+        moves += evasions.size();
+    }
+
+    double ns[2];
+    for (int use_evasions = 1; use_evasions >= 0; use_evasions--)
+    {
+        long checksum = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (int n = 0; n < iterations; n++)
+        {
+            for (Board &board : boards)
+            {
+                checksum += board.generate_moves(board.get_side(), GEN_ALL, use_evasions).size();
+            }
+        }
+        auto end = chrono::high_resolution_clock::now();
+        ns[use_evasions] = chrono::duration<double, nano>(end - start).count() / ((double)iterations * boards.size());
+        if (checksum != moves * iterations)
+        {
+            mismatches++;
+        }
+    }
+
+    cout << boards.size() << " positions in check, " << (double)moves / boards.size() << " evasions each, "
+         << mismatches << " mismatches" << endl;
+    cout << fixed << setprecision(1);
+    cout << "evasion generator: " << ns[1] << " ns/position" << endl;
+    cout << "checkmask path:    " << ns[0] << " ns/position (" << ns[0] / ns[1] << "x)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include "../include/board.hpp"
+#include <iomanip>
+
+/*
+ * gives_check microbenchmark: average cost of gives_check() against playing
+ * the move and testing the enemy king with get_attacks(), over every legal
+ * move in a set of positions rich in checks, promotions and castling.
+ *
+ * usage: gives_check_bench [iterations]
+ */
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+
+    Board boards[5];
+    vector<int> moves[5];
+    long calls_per_iteration = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        boards[i].load_fen(positions[i]);
+        moves[i] = boards[i].generate_legal_moves(boards[i].get_side());
+        calls_per_iteration += moves[i].size();
+    }
+
+    long checks = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (int n = 0; n < iterations; n++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            for (int move : moves[i])
+            {
+                checks += boards[i].gives_check(move);
+            }
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double gives_check_ns = chrono::duration<double, nano>(end - start).count() / (iterations * calls_per_iteration);
+
+    long reference_checks = 0;
+    start = chrono::high_resolution_clock::now();
+    for (int n = 0; n < iterations; n++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            Color us = boards[i].get_side();
+            for (int move : moves[i])
+            {
+                boards[i].make_move(move);
+                reference_checks += (boards[i].get_attacks(us) & boards[i].get_pieces((Color)!us, KING)) != 0;
+                boards[i].unmake_move();
+            }
+        }
+    }
+    end = chrono::high_resolution_clock::now();
+    double make_ns = chrono::duration<double, nano>(end - start).count() / (iterations * calls_per_iteration);
+
+    cout << calls_per_iteration << " moves x " << iterations << " iterations, "
+         << checks / iterations << " checks (make-and-test: " << reference_checks / iterations << ")" << endl;
+    cout << fixed << setprecision(1);
+    cout << "gives_check:   " << gives_check_ns << " ns/call" << endl;
+    cout << "make-and-test: " << make_ns << " ns/call (" << make_ns / gives_check_ns << "x)" << endl;
+
+    return 0;
+}
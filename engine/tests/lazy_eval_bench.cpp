@@ -0,0 +1,77 @@
+#include <chrono>
+#include "../include/evaluation.hpp"
+#include <iomanip>
+
+/*
+ * Lazy evaluation accuracy on a fixed test set: every position of a depth 3
+ * tree below a few positions, each evaluated with a null window at the
+ * negated evaluation of its parent, much like a quiescence stand pat after a
+ * capture. Reports how many evaluations were cut short, how many of those
+ * landed on the wrong side of the window compared with the full evaluation,
+ * the average error of the cut-short scores, and the time with and without.
+ *
+ * usage: lazy_eval_bench [depth]
+ */
+static void walk(Board &board, Evaluator &evaluator, int depth, int parent, bool lazy, long &evals)
+{
+    int alpha = -parent - 1, beta = -parent + 1;
+    int score = lazy ? evaluator.evaluate(board, alpha, beta) : evaluator.evaluate(board);
+    evals++;
+    if (depth == 0)
+    {
+        return;
+    }
+    for (int move : board.generate_legal_moves(board.get_side()))
+    {
+        board.make_move(move);
+        walk(board, evaluator, depth - 1, score, lazy, evals);
+        board.unmake_move();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r1bq1rk1/pp2nppp/2n1p3/3pP3/1b1P4/2NB1N2/PP3PPP/R1BQK2R w KQ - 0 1",
+    };
+    int depth = argc > 1 ? atoi(argv[1]) : 3;
+
+    double elapsed[2] = {};
+    long evals = 0, lazy_exits = 0;
+    for (bool lazy : {false, true})
+    {
+        Evaluator evaluator; // fresh caches for each pass
+        evals = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (const char *fen : positions)
+        {
+            Board board;
+            board.load_fen(fen);
+            walk(board, evaluator, depth, -evaluator.evaluate(board), lazy, evals);
+        }
+        elapsed[lazy] = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        lazy_exits = evaluator.lazy_exits;
+    }
+
+    // another lazy pass, checking every cut-short score against the full one
+    Evaluator evaluator;
+    evaluator.verify_lazy = true;
+    evals = 0;
+    for (const char *fen : positions)
+    {
+        Board board;
+        board.load_fen(fen);
+        walk(board, evaluator, depth, -evaluator.evaluate(board), true, evals);
+    }
+
+    cout << "positions        " << evals << endl;
+    cout << "cut short        " << lazy_exits << " (" << fixed << setprecision(1) << 100.0 * lazy_exits / evals << "%)" << endl;
+    cout << "wrong side       " << evaluator.lazy_wrong_side << " (" << 100.0 * evaluator.lazy_wrong_side / max(lazy_exits, 1L) << "% of cut short)" << endl;
+    cout << "mean abs error   " << (double)evaluator.lazy_error / max(lazy_exits, 1L) << " cp" << endl;
+    cout << "time full/lazy   " << setprecision(3) << elapsed[0] << " s / " << elapsed[1] << " s" << endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include "../include/board.hpp"
+#include <iomanip>
+
+/*
+ * Network evaluation throughput: evals/sec over every node of a fixed depth
+ * tree below a few positions, once with the accumulators carried along
+ * incrementally by make_move and once refreshing them from scratch before
+ * every evaluation. Also checks that both give the same accumulators.
+ *
+ * Without a network file a random one is written to a temporary file, which
+ * is fine for timing and for checking the incremental updates.
+ *
+ * usage: nnue_bench [network file] [depth]
+ */
+static void write_random_network(const string &path)
+{
+    std::mt19937 rng(12345);
+    auto fill = [&rng](std::ofstream &out, int count, int size, int range)
+    {
+        std::uniform_int_distribution<int> value(-range, range);
+        for (int i = 0; i < count; i++)
+        {
+            int64_t v = value(rng);
+            out.write((const char *)&v, size); // little endian: the low bytes come first
+        }
+    };
+    std::ofstream out(path, std::ios::binary);
+    char header[64] = {'N', 'N', 'U', 'E'};
+    uint32_t version = NNUE::VERSION;
+    memcpy(header + 4, &version, sizeof(version));
+    out.write(header, sizeof(header));
+    fill(out, NNUE::HALF, 2, 32);
+    fill(out, NNUE::INPUTS * NNUE::HALF, 2, 8);
+    fill(out, NNUE::HIDDEN1, 4, 256);
+    fill(out, NNUE::HIDDEN1 * 2 * NNUE::HALF, 1, 32);
+    fill(out, NNUE::HIDDEN2, 4, 256);
+    fill(out, NNUE::HIDDEN2 * NNUE::HIDDEN1, 1, 64);
+    char bias[64] = {};
+    out.write(bias, sizeof(bias));
+    fill(out, NNUE::HIDDEN2, 1, 64);
+}
+
+struct Counters
+{
+    long evals = 0;
+    long mismatches = 0;
+    long checksum = 0;
+};
+
+static void walk(Board &board, int depth, bool refresh, bool verify, Counters &counters)
+{
+    if (refresh)
+    {
+        board.refresh_accumulator();
+    }
+    if (verify)
+    {
+        Accumulator incremental = board.get_accumulator();
+        board.refresh_accumulator();
+        counters.mismatches += memcmp(&incremental, &board.get_accumulator(), sizeof(incremental)) != 0;
+    }
+    counters.checksum += NNUE::evaluate(board.get_accumulator(), board.get_side());
+    counters.evals++;
+    if (depth == 0)
+    {
+        return;
+    }
+    for (int move : board.generate_legal_moves(board.get_side()))
+    {
+        board.make_move(move);
+        walk(board, depth - 1, refresh, verify, counters);
+        board.unmake_move();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    };
+    string path = argc > 1 ? argv[1] : "";
+    int depth = argc > 2 ? atoi(argv[2]) : 3;
+
+    bool generated = path.empty();
+    if (generated)
+    {
+        path = "/tmp/nnue_bench_random.nnue";
+        write_random_network(path);
+    }
+    if (!NNUE::load(path))
+    {
+        cerr << "could not load " << path << endl;
+        return 1;
+    }
+
+    Counters verified;
+    for (const char *fen : positions)
+    {
+        Board board;
+        board.load_fen(fen);
+        walk(board, depth, false, true, verified);
+    }
+    cout << "accumulator mismatches: " << verified.mismatches << " of " << verified.evals << endl;
+
+    for (bool refresh : {false, true})
+    {
+        Counters counters;
+        auto start = chrono::high_resolution_clock::now();
+        for (const char *fen : positions)
+        {
+            Board board;
+            board.load_fen(fen);
+            walk(board, depth, refresh, false, counters);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double elapsed = chrono::duration<double>(end - start).count();
+        cout << setw(14) << left << (refresh ? "full refresh" : "incremental") << right
+             << setw(10) << counters.evals << " evals"
+             << setw(12) << fixed << setprecision(0) << counters.evals / elapsed << " evals/s"
+             << "  checksum " << counters.checksum << endl;
+    }
+
+    if (generated)
+    {
+        remove(path.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include "../include/search.hpp"
+#include <iomanip>
+
+/*
+ * Selective search benchmark: single threaded time-to-depth and node count
+ * (the bench signature) with every pruning technique enabled, then with each
+ * one switched off in turn, then with all of them off. Also shows how often
+ * PVS null-window searches and aspiration windows had to be re-searched, and
+ * the pawn structure and evaluation cache hit rates and the share of
+ * evaluations cut short by lazy evaluation.
+ *
+ * usage: search_bench [depth]
+ */
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r1bq1rk1/pp2nppp/2n1p3/3pP3/1b1P4/2NB1N2/PP3PPP/R1BQK2R w KQ - 0 1",
+    };
+    int depth = argc > 1 ? atoi(argv[1]) : 8;
+
+    struct Config
+    {
+        const char *name;
+        bool SearchOptions::*option; // the switch turned off, nullptr for none
+    };
+    Config configs[] = {
+        {"all on", nullptr},
+        {"no null move", &SearchOptions::null_move},
+        {"no lmr", &SearchOptions::late_move_reductions},
+        {"no reverse futility", &SearchOptions::reverse_futility},
+        {"no futility", &SearchOptions::futility},
+        {"no late move pruning", &SearchOptions::late_move_pruning},
+        {"no razoring", &SearchOptions::razoring},
+        {"no lazy eval", &SearchOptions::lazy_eval},
+        {"all off", nullptr},
+    };
+
+    TranspositionTable tt(64);
+    Search search(tt);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    cout << "depth " << depth << endl;
+    cout << setw(22) << left << "config" << right << setw(12) << "time (s)" << setw(14) << "nodes" << setw(12) << "nps" << setw(12) << "signature" << setw(10) << "pvs re" << setw(10) << "asp re" << setw(10) << "pawn hit" << setw(10) << "eval hit" << setw(8) << "lazy" << endl;
+
+    for (Config &config : configs)
+    {
+        search.options = SearchOptions();
+        if (config.option)
+        {
+            search.options.*config.option = false;
+        }
+        else if (string(config.name) == "all off")
+        {
+            search.options = {false, false, false, false, false, false, false};
+        }
+
+        double elapsed = 0;
+        long nodes = 0, pvs_researches = 0, aspiration_researches = 0, pawn_probes = 0, pawn_hits = 0, eval_probes = 0, eval_hits = 0, lazy_evals = 0;
+        u64 signature = 0; // hash of the best moves and scores, changes whenever the search result does
+        for (const char *fen : positions)
+        {
+            Board board;
+            board.load_fen(fen);
+            tt.clear();
+
+            auto start = chrono::high_resolution_clock::now();
+            SearchResult result = search.go(board, limits);
+            auto end = chrono::high_resolution_clock::now();
+
+            elapsed += chrono::duration<double>(end - start).count();
+            nodes += result.nodes;
+            pvs_researches += result.pvs_researches;
+            aspiration_researches += result.aspiration_researches;
+            pawn_probes += result.pawn_probes;
+            pawn_hits += result.pawn_hits;
+            eval_probes += result.eval_probes;
+            eval_hits += result.eval_hits;
+            lazy_evals += result.lazy_evals;
+            signature = signature * 31 + result.best_move * 7919 + result.score;
+        }
+
+        cout << setw(22) << left << config.name << right
+             << setw(12) << fixed << setprecision(3) << elapsed
+             << setw(14) << nodes
+             << setw(12) << setprecision(0) << nodes / elapsed
+             << setw(12) << hex << (signature & 0xffffffff) << dec
+             << setw(10) << pvs_researches
+             << setw(10) << aspiration_researches
+             << setw(9) << setprecision(1) << 100.0 * pawn_hits / max(pawn_probes, 1L) << "%"
+             << setw(9) << 100.0 * eval_hits / max(eval_probes, 1L) << "%"
+             << setw(7) << 100.0 * lazy_evals / max(eval_probes, 1L) << "%" << endl;
+    }
+
+    return 0;
+}
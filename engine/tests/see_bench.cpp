@@ -0,0 +1,67 @@
+#include <chrono>
+#include "../include/board.hpp"
+#include <iomanip>
+
+/*
+ * Static exchange evaluation microbenchmark: average cost of one see() and
+ * one see_ge() call over every capture in a set of tactical positions.
+ *
+ * usage: see_bench [iterations]
+ */
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2nppp/2n1p3/3pP3/1b1P4/2NB1N2/PP3PPP/R1BQK2R w KQ - 0 1",
+        "2r2rk1/1bqnbppp/p2ppn2/1p6/3NPP2/1BN1B3/PPPQ2PP/2KR3R w - - 0 1",
+    };
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+
+    Board boards[5];
+    vector<int> captures[5];
+    long calls_per_iteration = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        boards[i].load_fen(positions[i]);
+        captures[i] = boards[i].generate_moves(boards[i].get_side(), GEN_CAPTURES);
+        calls_per_iteration += captures[i].size();
+    }
+
+    long checksum = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (int n = 0; n < iterations; n++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            for (int move : captures[i])
+            {
+                checksum += boards[i].see(move);
+            }
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double see_ns = chrono::duration<double, nano>(end - start).count() / (iterations * calls_per_iteration);
+
+    start = chrono::high_resolution_clock::now();
+    for (int n = 0; n < iterations; n++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            for (int move : captures[i])
+            {
+                checksum += boards[i].see_ge(move, 0);
+            }
+        }
+    }
+    end = chrono::high_resolution_clock::now();
+    double see_ge_ns = chrono::duration<double, nano>(end - start).count() / (iterations * calls_per_iteration);
+
+    cout << calls_per_iteration << " captures x " << iterations << " iterations (checksum " << checksum << ")" << endl;
+    cout << fixed << setprecision(1);
+    cout << "see:    " << see_ns << " ns/call" << endl;
+    cout << "see_ge: " << see_ge_ns << " ns/call" << endl;
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include "../include/search.hpp"
+#include <iomanip>
+#include <thread>
+
+/*
+ * Lazy SMP scaling benchmark: time-to-depth for each thread count,
+ * relative to the single threaded search.
+ *
+ * usage: smp_bench [depth]
+ */
+int main(int argc, char *argv[])
+{
+    const char *positions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    int thread_counts[] = {1, 2, 4, 8, 16};
+    int depth = argc > 1 ? atoi(argv[1]) : 7;
+
+    TranspositionTable tt(64);
+    Search search(tt);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    double base_time = 0;
+    cout << "depth " << depth << ", " << std::thread::hardware_concurrency() << " hardware threads" << endl;
+    cout << setw(8) << "threads" << setw(12) << "time (s)" << setw(14) << "nodes" << setw(12) << "nps" << setw(10) << "speedup" << setw(12) << "1st cut %" << endl;
+
+    for (int threads : thread_counts)
+    {
+        search.set_threads(threads);
+        double elapsed = 0;
+        long nodes = 0, cutoffs = 0, first_move_cutoffs = 0;
+        for (const char *fen : positions)
+        {
+            Board board;
+            board.load_fen(fen);
+            tt.clear();
+
+            auto start = chrono::high_resolution_clock::now();
+            SearchResult result = search.go(board, limits);
+            auto end = chrono::high_resolution_clock::now();
+
+            elapsed += chrono::duration<double>(end - start).count();
+            nodes += result.nodes;
+            cutoffs += result.beta_cutoffs;
+            first_move_cutoffs += result.first_move_cutoffs;
+        }
+        if (threads == 1)
+        {
+            base_time = elapsed;
+        }
+
+        cout << setw(8) << threads
+             << setw(12) << fixed << setprecision(3) << elapsed
+             << setw(14) << nodes
+             << setw(12) << setprecision(0) << nodes / elapsed
+             << setw(10) << setprecision(2) << base_time / elapsed
+             << setw(12) << setprecision(1) << (cutoffs ? 100.0 * first_move_cutoffs / cutoffs : 0.0) << endl;
+    }
+
+    // per-thread breakdown of the last search
+    cout << endl;
+    search.print_thread_breakdown();
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <chrono>
+#include "../include/search.hpp"
+#include <iomanip>
+#include <thread>
+
+/*
+ * How long an infinite search takes to return after request_stop(), which is
+ * what the UCI reader thread calls on "stop", for growing thread counts.
+ *
+ * usage: stop_latency [search ms]
+ */
+int main(int argc, char *argv[])
+{
+    int search_ms = argc > 1 ? atoi(argv[1]) : 300;
+    int thread_counts[] = {1, 4, 16, 64};
+    const int repeats = 5;
+
+    TranspositionTable tt(64);
+    Search search(tt);
+    Board board;
+    board.load_fen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+    SearchLimits limits;
+    limits.infinite = true;
+
+    cout << setw(8) << "threads" << setw(14) << "avg (ms)" << setw(14) << "max (ms)" << endl;
+    for (int threads : thread_counts)
+    {
+        search.set_threads(threads);
+        double total = 0, worst = 0;
+        for (int i = 0; i < repeats; i++)
+        {
+            SearchResult result;
+            search.start(board, limits);
+            std::thread searcher([&]
+                                 { result = search.run(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(search_ms));
+
+            auto start = chrono::steady_clock::now();
+            search.request_stop();
+            searcher.join();
+            double latency = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+            total += latency;
+            worst = std::max(worst, latency);
+        }
+        cout << setw(8) << threads
+             << setw(14) << fixed << setprecision(3) << total / repeats
+             << setw(14) << worst << endl;
+    }
+
+    return 0;
+}
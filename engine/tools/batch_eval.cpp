@@ -0,0 +1,183 @@
+#include <chrono>
+#include <fstream>
+#include "../include/batch_eval.hpp"
+#include "../include/evaluation.hpp"
+
+/*
+ * Scores a file of positions with the static evaluation, one score per line
+ * on stdout in input order (centipawns, side to move's point of view).
+ * A position that can't be read or isn't a legal setup gets "none" instead,
+ * so line n of the output always belongs to position n of the input.
+ *
+ * The input is read and scored in chunks, so files of any size stream
+ * through in bounded memory. Text input is one FEN or EPD per line (fields
+ * after the en passant square are ignored); binary input is a sequence of
+ * 32 byte PackedPosition records.
+ *
+ * usage: batch_eval [options] <file | ->
+ *   --binary        input is packed positions
+ *   --pack <out>    convert text input to packed positions instead of scoring it
+ *   --threads <n>   worker threads, all hardware threads by default
+ *   --eval <file>   network file for the evaluation
+ *   --compare       text input only: also time load_fen + evaluate on one thread
+ *                   and check the scores agree
+ */
+static const size_t CHUNK = 1 << 16;
+
+// positions holds the records that were accepted, accepted says for every record read whether it was
+static size_t read_chunk(istream &input, bool binary, vector<PackedPosition> &positions, vector<bool> &accepted,
+                         vector<string> &lines, long &line_number)
+{
+    positions.clear();
+    accepted.clear();
+    lines.clear();
+    if (binary)
+    {
+        vector<PackedPosition> records(CHUNK);
+        input.read((char *)records.data(), CHUNK * sizeof(PackedPosition));
+        records.resize(input.gcount() / sizeof(PackedPosition));
+        for (const PackedPosition &record : records)
+        {
+            line_number++;
+            accepted.push_back(record.valid());
+            if (accepted.back())
+            {
+                positions.push_back(record);
+            }
+            else
+            {
+                cerr << "record " << line_number << ": bad position, scored as none" << endl;
+            }
+        }
+        return accepted.size();
+    }
+    string line;
+    while (accepted.size() < CHUNK && getline(input, line))
+    {
+        line_number++;
+        if (line.empty())
+        {
+            continue;
+        }
+        PackedPosition packed;
+        accepted.push_back(PackedPosition::from_fen(line, packed));
+        if (!accepted.back())
+        {
+            cerr << "line " << line_number << ": bad position, scored as none" << endl;
+            continue;
+        }
+        positions.push_back(packed);
+        lines.push_back(line);
+    }
+    return accepted.size();
+}
+
+int main(int argc, char *argv[])
+{
+    bool binary = false, compare = false;
+    int threads = 0;
+    string path, pack_path, eval_path;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--binary")
+            binary = true;
+        else if (arg == "--compare")
+            compare = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (arg == "--pack" && i + 1 < argc)
+            pack_path = argv[++i];
+        else if (arg == "--eval" && i + 1 < argc)
+            eval_path = argv[++i];
+        else
+            path = arg;
+    }
+    if (path.empty())
+    {
+        cerr << "usage: batch_eval [--binary] [--pack <out>] [--threads <n>] [--eval <network>] [--compare] <file | ->" << endl;
+        return 1;
+    }
+    if (!eval_path.empty() && !NNUE::load(eval_path))
+    {
+        cerr << "could not load network " << eval_path << endl;
+        return 1;
+    }
+
+    ifstream file;
+    if (path != "-")
+    {
+        file.open(path, binary ? ios::binary : ios::in);
+        if (!file)
+        {
+            cerr << "could not open " << path << endl;
+            return 1;
+        }
+    }
+    istream &input = path == "-" ? cin : file;
+    ofstream pack_output;
+    if (!pack_path.empty())
+    {
+        pack_output.open(pack_path, ios::binary);
+    }
+
+    AttackTables::init(); // outside the timing, the magic search takes a few seconds
+    BatchEvaluator batch(threads);
+    vector<PackedPosition> positions;
+    vector<bool> accepted;
+    vector<string> lines;
+    vector<int> scores;
+    long line_number = 0, total = 0, mismatches = 0;
+    double batch_time = 0, single_time = 0;
+    string output;
+
+    while (read_chunk(input, binary, positions, accepted, lines, line_number))
+    {
+        total += positions.size();
+        if (pack_output.is_open())
+        {
+            pack_output.write((const char *)positions.data(), positions.size() * sizeof(PackedPosition));
+            continue;
+        }
+
+        scores.resize(positions.size());
+        auto start = chrono::high_resolution_clock::now();
+        batch.evaluate(positions.data(), positions.size(), scores.data());
+        batch_time += chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+        output.clear();
+        size_t next = 0;
+        for (bool ok : accepted)
+        {
+            output += ok ? to_string(scores[next++]) : "none";
+            output += '\n';
+        }
+        cout << output;
+
+        if (compare && !binary)
+        {
+            Board board;
+            Evaluator evaluator;
+            start = chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < lines.size(); i++)
+            {
+                board.load_fen(lines[i]);
+                mismatches += evaluator.evaluate(board) != scores[i];
+            }
+            single_time += chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        }
+    }
+
+    if (pack_output.is_open())
+    {
+        cerr << "packed " << total << " positions into " << pack_path << endl;
+        return 0;
+    }
+    cerr << total << " positions, batch " << (long)(total / max(batch_time, 1e-9)) << " evals/s" << endl;
+    if (compare && !binary)
+    {
+        cerr << "load_fen + evaluate " << (long)(total / max(single_time, 1e-9)) << " evals/s, "
+             << mismatches << " mismatching scores" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,558 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <thread>
+#include "../include/batch_eval.hpp"
+#include "../include/evaluation.hpp"
+
+/*
+ * Tunes the hand-written evaluation against game results (Texel's method):
+ * minimises the mean squared error between each position's result and a
+ * sigmoid of its static evaluation, and writes the tuned constants as a
+ * header to paste back into psqt.cpp and the term headers.
+ *
+ * Every tuned term is linear in its weight, so the evaluation of a position
+ * is sum(coef * (mg * phase + eg * (1 - phase))) over a handful of sparse
+ * features plus a fixed offset. The features are extracted once, in
+ * parallel, and an epoch is then only a dot product per position. The
+ * offset is whatever the linear terms don't explain (king safety, which is
+ * quadratic, and tapering's rounding) and is held at its initial value.
+ * Known endgames and scaled positions are left out, the tuned terms don't
+ * decide them.
+ *
+ * Input is one position per line, FEN or EPD, with the game result from
+ * white's point of view anywhere after it: 1-0, 0-1, 1/2-1/2, [1.0], [0.5]
+ * or [0.0].
+ *
+ * usage: tune [options] <file>
+ *   --epochs <n>    Adam epochs, 500 by default
+ *   --rate <r>      learning rate in centipawns, 1 by default
+ *   --threads <n>   worker threads, all hardware threads by default
+ *   --out <file>    output header, tuned_constants.hpp by default
+ */
+
+// one mg/eg weight pair per parameter: piece-square tables (material included), then the terms
+enum Parameter
+{
+    PSQ = 0, // + type * 64 + square, white's view
+    DOUBLED = PSQ + 7 * 64,
+    ISOLATED,
+    BACKWARD,
+    PASSED, // + relative rank, 1..6
+    BISHOP_PAIR = PASSED + 7,
+    KNIGHT_PAWN,
+    ROOK_PAWN,
+    MOBILITY, // + piece type
+    THREAT_BY_LESSER = MOBILITY + 7,
+    HANGING,
+    PARAMETER_COUNT
+};
+
+struct Feature
+{
+    uint16_t parameter;
+    int16_t coef; // white's count minus black's
+};
+
+struct Sample
+{
+    uint32_t begin; // first feature, the sample's run ends where the next one begins
+    float phase;    // middlegame share, 0..1
+    float result;   // 1 white won, 0.5 draw, 0 black won
+    float offset;   // centipawns, white's view
+};
+
+struct Weight
+{
+    double mg, eg;
+};
+
+static void add(vector<Feature> &features, int parameter, int coef)
+{
+    if (coef)
+    {
+        features.push_back({(uint16_t)parameter, (int16_t)coef});
+    }
+}
+
+// features of one position, white's count minus black's
+static void extract(Board &board, const AttackInfo &attacks, vector<Feature> &features)
+{
+    int counts[PARAMETER_COUNT] = {};
+    for (Color color : {WHITE, BLACK})
+    {
+        int sign = color == WHITE ? 1 : -1;
+        for (int type = PAWN; type <= KING; type++)
+        {
+            for (u64 bitboard = board.get_pieces(color, (PieceType)type); bitboard; bitboard &= bitboard - 1)
+            {
+                int square = __builtin_ctzll(bitboard);
+                counts[PSQ + type * 64 + (color == WHITE ? square : square ^ 56)] += sign;
+            }
+        }
+
+        int pawns = __builtin_popcountll(board.get_pieces(color, PAWN));
+        counts[BISHOP_PAIR] += sign * (__builtin_popcountll(board.get_pieces(color, BISHOP)) >= 2);
+        counts[KNIGHT_PAWN] += sign * (pawns - 5) * __builtin_popcountll(board.get_pieces(color, KNIGHT));
+        counts[ROOK_PAWN] += sign * (pawns - 5) * __builtin_popcountll(board.get_pieces(color, ROOK));
+
+        for (int type = KNIGHT; type <= QUEEN; type++)
+        {
+            counts[MOBILITY + type] += sign * attacks.mobility[color][type];
+        }
+        counts[THREAT_BY_LESSER] += sign * __builtin_popcountll(attacks.threatened[color]);
+        counts[HANGING] += sign * __builtin_popcountll(attacks.hanging[color]);
+    }
+
+    PawnTerms terms = PawnTable::classify(board.get_pieces(WHITE, PAWN), board.get_pieces(BLACK, PAWN));
+    for (Color color : {WHITE, BLACK})
+    {
+        int sign = color == WHITE ? 1 : -1;
+        counts[DOUBLED] += sign * __builtin_popcountll(terms.doubled[color]);
+        counts[ISOLATED] += sign * __builtin_popcountll(terms.isolated[color]);
+        counts[BACKWARD] += sign * __builtin_popcountll(terms.backward[color]);
+        for (u64 passed = terms.passed[color]; passed; passed &= passed - 1)
+        {
+            int square = __builtin_ctzll(passed);
+            counts[PASSED + (color == WHITE ? 7 - square / 8 : square / 8)] += sign;
+        }
+    }
+
+    for (int parameter = 0; parameter < PARAMETER_COUNT; parameter++)
+    {
+        add(features, parameter, counts[parameter]);
+    }
+}
+
+// the weights the evaluation uses now, in the tuner's layout
+static vector<Weight> current_weights()
+{
+    vector<Weight> weights(PARAMETER_COUNT, {0, 0});
+    auto set = [&](int parameter, Score score)
+    { weights[parameter] = {(double)mg_value(score), (double)eg_value(score)}; };
+
+    for (int type = PAWN; type <= KING; type++)
+    {
+        for (int square = 0; square < 64; square++)
+        {
+            set(PSQ + type * 64 + square, PSQT::table[WHITE][type][square]);
+        }
+    }
+    set(DOUBLED, PawnTable::DOUBLED);
+    set(ISOLATED, PawnTable::ISOLATED);
+    set(BACKWARD, PawnTable::BACKWARD);
+    for (int rank = 1; rank <= 6; rank++)
+    {
+        set(PASSED + rank, PawnTable::PASSED[rank]);
+    }
+    set(BISHOP_PAIR, MaterialTable::BISHOP_PAIR);
+    set(KNIGHT_PAWN, MaterialTable::KNIGHT_PAWN);
+    set(ROOK_PAWN, MaterialTable::ROOK_PAWN);
+    for (int type = KNIGHT; type <= QUEEN; type++)
+    {
+        set(MOBILITY + type, Evaluator::MOBILITY[type]);
+    }
+    set(THREAT_BY_LESSER, Evaluator::THREAT_BY_LESSER);
+    set(HANGING, Evaluator::HANGING);
+    return weights;
+}
+
+// 1, 0.5 or 0 for a recognised result, -1 otherwise
+static float parse_result(const string &line)
+{
+    static const pair<const char *, float> RESULTS[] = {{"1/2-1/2", 0.5f}, {"1-0", 1.0f}, {"0-1", 0.0f},
+                                                        {"[0.5]", 0.5f}, {"[1.0]", 1.0f}, {"[0.0]", 0.0f}};
+    for (auto &result : RESULTS)
+    {
+        if (line.find(result.first) != string::npos)
+        {
+            return result.second;
+        }
+    }
+    return -1;
+}
+
+// sum(coef * (mg * phase + eg * (1 - phase))) over one sample's features
+static double linear(const Feature *begin, const Feature *end, float phase, const vector<Weight> &weights)
+{
+    double mg = 0, eg = 0;
+    for (const Feature *feature = begin; feature < end; feature++)
+    {
+        mg += feature->coef * weights[feature->parameter].mg;
+        eg += feature->coef * weights[feature->parameter].eg;
+    }
+    return mg * phase + eg * (1 - phase);
+}
+
+/*
+ * The samples and their features in two flat arrays, and the threads that
+ * sweep over them. Each thread owns a contiguous slice of the samples.
+ */
+class Tuner
+{
+private:
+    int thread_count;
+    vector<Sample> samples;
+    vector<Feature> features;
+
+    template <typename Work>
+    void parallel(size_t count, Work work)
+    {
+        size_t slice = (count + thread_count - 1) / thread_count;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < thread_count; i++)
+        {
+            threads.emplace_back(work, i, std::min(count, i * slice), std::min(count, (i + 1) * slice));
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    const Feature *features_end(size_t i) const
+    {
+        return features.data() + (i + 1 < samples.size() ? samples[i + 1].begin : features.size());
+    }
+
+    double sigmoid(double score) const
+    {
+        return 1 / (1 + std::pow(10.0, -k * score / 400));
+    }
+
+public:
+    double k = 1; // sigmoid scale, fitted to the data before tuning
+
+    Tuner(int threads)
+    {
+        thread_count = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    size_t size() const
+    {
+        return samples.size();
+    }
+
+    size_t feature_count() const
+    {
+        return features.size();
+    }
+
+    /*
+     * Evaluates every position once with the real evaluation and keeps its
+     * features, and as offset whatever the features don't account for under
+     * the starting weights. Threads fill their own buffers, which are joined
+     * in order afterwards.
+     */
+    void load(const vector<PackedPosition> &positions, const vector<float> &results, const vector<Weight> &weights)
+    {
+        vector<vector<Sample>> thread_samples(thread_count);
+        vector<vector<Feature>> thread_features(thread_count);
+        parallel(positions.size(), [&](int thread, size_t first, size_t last)
+                 {
+            Board board;
+            Evaluator evaluator;
+            vector<Sample> &out = thread_samples[thread];
+            vector<Feature> &out_features = thread_features[thread];
+            for (size_t i = first; i < last; i++)
+            {
+                positions[i].unpack(board);
+                MaterialEntry *material = evaluator.material_table.probe(board);
+                if (material->evaluation || material->scaling)
+                {
+                    continue;
+                }
+                long hits = evaluator.cache_hits;
+                int score = evaluator.evaluate(board);
+                if (evaluator.cache_hits != hits)
+                {
+                    // a repeated position; the attack maps are only filled in by a real evaluation
+                    evaluator.clear_cache();
+                    score = evaluator.evaluate(board);
+                }
+                score = board.get_side() == WHITE ? score : -score;
+
+                Sample sample;
+                sample.begin = out_features.size();
+                sample.phase = material->phase / 256.0f;
+                sample.result = results[i];
+                extract(board, evaluator.attacks, out_features);
+                sample.offset = score - linear(out_features.data() + sample.begin, out_features.data() + out_features.size(), sample.phase, weights);
+                out.push_back(sample);
+            } });
+
+        for (int thread = 0; thread < thread_count; thread++)
+        {
+            uint32_t base = features.size();
+            for (Sample sample : thread_samples[thread])
+            {
+                sample.begin += base;
+                samples.push_back(sample);
+            }
+            features.insert(features.end(), thread_features[thread].begin(), thread_features[thread].end());
+        }
+    }
+
+    // mean squared error between results and predictions
+    double error(const vector<Weight> &weights)
+    {
+        vector<double> sums(thread_count);
+        parallel(samples.size(), [&](int thread, size_t first, size_t last)
+                 {
+            double sum = 0;
+            for (size_t i = first; i < last; i++)
+            {
+                const Sample &sample = samples[i];
+                double difference = sample.result - sigmoid(sample.offset + linear(&features[sample.begin], features_end(i), sample.phase, weights));
+                sum += difference * difference;
+            }
+            sums[thread] = sum; });
+        double sum = 0;
+        for (double thread_sum : sums)
+        {
+            sum += thread_sum;
+        }
+        return sum / std::max<size_t>(samples.size(), 1);
+    }
+
+    // the scale that best maps the current evaluation to results, by ternary search
+    void fit_k(const vector<Weight> &weights)
+    {
+        double low = 0.1, high = 4;
+        for (int i = 0; i < 40; i++)
+        {
+            double a = low + (high - low) / 3, b = high - (high - low) / 3;
+            k = a;
+            double error_a = error(weights);
+            k = b;
+            double error_b = error(weights);
+            (error_a < error_b ? high : low) = error_a < error_b ? b : a;
+        }
+        k = (low + high) / 2;
+    }
+
+    /*
+     * Gradient of the error in each weight, up to a constant factor (Adam
+     * doesn't care about scale). Each thread sums into its own copy.
+     */
+    void gradient(const vector<Weight> &weights, vector<Weight> &gradient)
+    {
+        vector<vector<Weight>> sums(thread_count, vector<Weight>(PARAMETER_COUNT, {0, 0}));
+        parallel(samples.size(), [&](int thread, size_t first, size_t last)
+                 {
+            vector<Weight> &sum = sums[thread];
+            for (size_t i = first; i < last; i++)
+            {
+                const Sample &sample = samples[i];
+                const Feature *end = features_end(i);
+                double prediction = sigmoid(sample.offset + linear(&features[sample.begin], end, sample.phase, weights));
+                double slope = (prediction - sample.result) * prediction * (1 - prediction);
+                double mg = slope * sample.phase, eg = slope * (1 - sample.phase);
+                for (const Feature *feature = &features[sample.begin]; feature < end; feature++)
+                {
+                    sum[feature->parameter].mg += feature->coef * mg;
+                    sum[feature->parameter].eg += feature->coef * eg;
+                }
+            } });
+
+        gradient.assign(PARAMETER_COUNT, {0, 0});
+        for (const vector<Weight> &sum : sums)
+        {
+            for (int parameter = 0; parameter < PARAMETER_COUNT; parameter++)
+            {
+                gradient[parameter].mg += sum[parameter].mg;
+                gradient[parameter].eg += sum[parameter].eg;
+            }
+        }
+    }
+};
+
+static void adam(Tuner &tuner, vector<Weight> &weights, int epochs, double rate)
+{
+    constexpr double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+    vector<Weight> gradient, m(PARAMETER_COUNT, {0, 0}), v(PARAMETER_COUNT, {0, 0});
+    auto step = [&](double &weight, double &m, double &v, double g, int epoch)
+    {
+        m = BETA1 * m + (1 - BETA1) * g;
+        v = BETA2 * v + (1 - BETA2) * g * g;
+        double m_hat = m / (1 - std::pow(BETA1, epoch)), v_hat = v / (1 - std::pow(BETA2, epoch));
+        weight -= rate * m_hat / (std::sqrt(v_hat) + EPSILON);
+    };
+
+    for (int epoch = 1; epoch <= epochs; epoch++)
+    {
+        tuner.gradient(weights, gradient);
+        for (int parameter = 0; parameter < PARAMETER_COUNT; parameter++)
+        {
+            step(weights[parameter].mg, m[parameter].mg, v[parameter].mg, gradient[parameter].mg, epoch);
+            step(weights[parameter].eg, m[parameter].eg, v[parameter].eg, gradient[parameter].eg, epoch);
+        }
+        if (epoch % 50 == 0 || epoch == epochs)
+        {
+            cerr << "epoch " << epoch << ", error " << tuner.error(weights) << endl;
+        }
+    }
+}
+
+static string score_text(const Weight &weight)
+{
+    return "make_score(" + to_string(lround(weight.mg)) + ", " + to_string(lround(weight.eg)) + ")";
+}
+
+/*
+ * Piece values are taken out of the tables again as the average over the
+ * squares a piece can stand on, so the tables come out in psqt.cpp's form.
+ */
+static void write_header(ostream &out, const vector<Weight> &weights, const Tuner &tuner, double before, double after)
+{
+    static const char *NAMES[7] = {"", "pawn", "knight", "bishop", "rook", "queen", "king"};
+    int values[2][7] = {};
+    for (int type = PAWN; type < KING; type++)
+    {
+        int first = type == PAWN ? 8 : 0, last = type == PAWN ? 56 : 64;
+        double mg = 0, eg = 0;
+        for (int square = first; square < last; square++)
+        {
+            mg += weights[PSQ + type * 64 + square].mg;
+            eg += weights[PSQ + type * 64 + square].eg;
+        }
+        values[0][type] = lround(mg / (last - first));
+        values[1][type] = lround(eg / (last - first));
+    }
+
+    out << "#pragma once\n\n";
+    out << "// tuned on " << tuner.size() << " positions, K = " << tuner.k << ", error " << before << " -> " << after << "\n\n";
+    out << "// psqt.hpp\n";
+    for (int phase = 0; phase < 2; phase++)
+    {
+        out << "static constexpr int " << (phase ? "EG" : "MG") << "_VALUES[7] = {";
+        for (int type = 0; type < 7; type++)
+        {
+            out << values[phase][type] << (type < 6 ? ", " : "};\n");
+        }
+    }
+
+    out << "\n// psqt.cpp\n";
+    for (int phase = 0; phase < 2; phase++)
+    {
+        out << "static constexpr int " << (phase ? "eg" : "mg") << "_tables[7][64] = {\n    {},\n";
+        for (int type = PAWN; type <= KING; type++)
+        {
+            out << "    // " << NAMES[type] << "\n    {";
+            for (int square = 0; square < 64; square++)
+            {
+                const Weight &weight = weights[PSQ + type * 64 + square];
+                bool unused = type == PAWN && (square < 8 || square >= 56);
+                long value = unused ? 0 : lround(phase ? weight.eg : weight.mg) - values[phase][type];
+                out << value << (square == 63 ? "},\n" : square % 8 == 7 ? ",\n     " : ", ");
+            }
+        }
+        out << "};\n\n";
+    }
+
+    out << "// pawns.hpp\n";
+    out << "static constexpr Score DOUBLED = " << score_text(weights[DOUBLED]) << ";\n";
+    out << "static constexpr Score ISOLATED = " << score_text(weights[ISOLATED]) << ";\n";
+    out << "static constexpr Score BACKWARD = " << score_text(weights[BACKWARD]) << ";\n";
+    out << "static constexpr Score PASSED[8] = {0";
+    for (int rank = 1; rank <= 6; rank++)
+    {
+        out << ", " << score_text(weights[PASSED + rank]);
+    }
+    out << ", 0};\n\n// material.hpp\n";
+    out << "static constexpr Score BISHOP_PAIR = " << score_text(weights[BISHOP_PAIR]) << ";\n";
+    out << "static constexpr Score KNIGHT_PAWN = " << score_text(weights[KNIGHT_PAWN]) << ";\n";
+    out << "static constexpr Score ROOK_PAWN = " << score_text(weights[ROOK_PAWN]) << ";\n\n";
+    out << "// evaluation.hpp\n";
+    out << "static constexpr Score MOBILITY[7] = {0, 0";
+    for (int type = KNIGHT; type <= QUEEN; type++)
+    {
+        out << ", " << score_text(weights[MOBILITY + type]);
+    }
+    out << ", 0};\n";
+    out << "static constexpr Score THREAT_BY_LESSER = " << score_text(weights[THREAT_BY_LESSER]) << ";\n";
+    out << "static constexpr Score HANGING = " << score_text(weights[HANGING]) << ";\n";
+}
+
+int main(int argc, char *argv[])
+{
+    int epochs = 500, threads = 0;
+    double rate = 1;
+    string path, out_path = "tuned_constants.hpp";
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--epochs" && i + 1 < argc)
+            epochs = atoi(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc)
+            rate = atof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc)
+            out_path = argv[++i];
+        else
+            path = arg;
+    }
+    if (path.empty())
+    {
+        cerr << "usage: tune [--epochs <n>] [--rate <r>] [--threads <n>] [--out <file>] <file>" << endl;
+        return 1;
+    }
+    ifstream file(path);
+    if (!file)
+    {
+        cerr << "could not open " << path << endl;
+        return 1;
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    vector<PackedPosition> positions;
+    vector<float> results;
+    string line;
+    long line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        if (line.empty())
+        {
+            continue;
+        }
+        PackedPosition packed;
+        float result = parse_result(line);
+        if (result < 0 || !PackedPosition::from_fen(line, packed))
+        {
+            cerr << "line " << line_number << ": no position or result, skipped" << endl;
+            continue;
+        }
+        positions.push_back(packed);
+        results.push_back(result);
+    }
+
+    Tuner tuner(threads);
+    PSQT::init(); // read below before any Board has set it up
+    vector<Weight> weights = current_weights();
+    tuner.load(positions, results, weights);
+    double load_time = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    cerr << tuner.size() << " of " << positions.size() << " positions kept, " << tuner.feature_count() << " features, "
+         << load_time << "s to load" << endl;
+    positions = vector<PackedPosition>();
+
+    tuner.fit_k(weights);
+    double before = tuner.error(weights);
+    cerr << "K " << tuner.k << ", error " << before << endl;
+
+    start = chrono::high_resolution_clock::now();
+    adam(tuner, weights, epochs, rate);
+    double after = tuner.error(weights);
+    cerr << epochs << " epochs in " << chrono::duration<double>(chrono::high_resolution_clock::now() - start).count() << "s" << endl;
+
+    ofstream out(out_path);
+    if (!out)
+    {
+        cerr << "could not write " << out_path << endl;
+        return 1;
+    }
+    write_header(out, weights, tuner, before, after);
+    cerr << "wrote " << out_path << endl;
+    return 0;
+}